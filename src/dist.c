@@ -12,12 +12,19 @@
 /* random number generator: uniform distribution from min to max inclusive */
 int64
 getrand(pcg64f_random_t *rng, int64 min, int64 max)
+{
+	return getrandU64(pcg64f_random_r(rng), min, max);
+}
+
+/* Same as getrand() but using the given 64-bit random number. */
+int64
+getrandU64(unsigned long long r, int64 min, int64 max)
 {
 	/*
 	 * Odd coding is so that min and max have approximately the same chance of
 	 * being selected as do numbers between them.
 	 */
-	return min + (int64) ((max - min + 1) * genrand64_real2(rng));
+	return min + (int64) ((max - min + 1) * rand64_real2(r));
 }
 
 /*
@@ -27,6 +34,14 @@ getrand(pcg64f_random_t *rng, int64 min, int64 max)
  */
 int64
 getExponentialRand(pcg64f_random_t *rng, int64 min, int64 max, double parameter)
+{
+	return getExponentialRandU64(pcg64f_random_r(rng), min, max, parameter);
+}
+
+/* Same as getExponentialRand() but using the given 64-bit random number. */
+int64
+getExponentialRandU64(unsigned long long r, int64 min, int64 max,
+		double parameter)
 {
 	double		cut,
 				uniform,
@@ -34,7 +49,7 @@ getExponentialRand(pcg64f_random_t *rng, int64 min, int64 max, double parameter)
 
 	cut = exp(-parameter);
 	/* erand in [0, 1), uniform in (0, 1] */
-	uniform = 1.0 - genrand64_real2(rng);
+	uniform = 1.0 - rand64_real2(r);
 
 	/*
 	 * inner expression in (cut, 1] (if parameter > 0), rand in [0, 1)
@@ -44,20 +59,41 @@ getExponentialRand(pcg64f_random_t *rng, int64 min, int64 max, double parameter)
 	return min + (int64) ((max - min + 1) * rand);
 }
 
+/*
+ * Turn a standard normal value into a gaussian distribution from min to max
+ * inclusive.
+ */
+static int64
+gaussianToRange(double stdev, int64 min, int64 max, double parameter)
+{
+	double		rand;
+
+	/* stdev is in [-parameter, parameter), normalization to [0,1) */
+	rand = (stdev + parameter) / (parameter * 2.0);
+
+	/* return int64 random number within between min and max */
+	return min + (int64) ((max - min + 1) * rand);
+}
+
 /* random number generator: gaussian distribution from min to max inclusive */
 int64
 getGaussianRand(pcg64f_random_t *rng, int64 min, int64 max, double parameter)
 {
-	double		stdev;
-	double		rand;
-
 	/*
 	 * Use the next random number to seed a new prng to keep the data
 	 * reproducible.
 	 */
+	return getGaussianRandSeed(pcg64f_random_r(rng), min, max, parameter);
+}
+
+/* Same as getGaussianRand() but using the given seed for the new prng. */
+int64
+getGaussianRandSeed(unsigned long long seed, int64 min, int64 max,
+		double parameter)
+{
+	double		stdev;
 
 	pcg64f_random_t grng;
-	unsigned long long seed = pcg64f_random_r(rng);
 
 	pcg64f_srandom_r(&grng, seed);
 
@@ -94,11 +130,31 @@ getGaussianRand(pcg64f_random_t *rng, int64 min, int64 max, double parameter)
 	}
 	while (stdev < -parameter || stdev >= parameter);
 
-	/* stdev is in [-parameter, parameter), normalization to [0,1) */
-	rand = (stdev + parameter) / (parameter * 2.0);
+	return gaussianToRange(stdev, min, max, parameter);
+}
 
-	/* return int64 random number within between min and max */
-	return min + (int64) ((max - min + 1) * rand);
+/*
+ * Same as getGaussianRand() but the random numbers for the Box-Muller transform
+ * are derived from the single seed with splitmix64, instead of seeding a new
+ * prng.
+ */
+int64
+getGaussianRandMix(unsigned long long seed, int64 min, int64 max,
+		double parameter)
+{
+	double		stdev;
+
+	do
+	{
+		double		rand1 = 1.0 - splitmix64_real1(&seed);
+		double		rand2 = 1.0 - splitmix64_real1(&seed);
+		double		var_sqrt = sqrt(-2.0 * log(rand1));
+
+		stdev = var_sqrt * sin(2.0 * M_PI * rand2);
+	}
+	while (stdev < -parameter || stdev >= parameter);
+
+	return gaussianToRange(stdev, min, max, parameter);
 }
 
 /*
@@ -107,6 +163,13 @@ getGaussianRand(pcg64f_random_t *rng, int64 min, int64 max, double parameter)
  */
 int64
 getPoissonRand(pcg64f_random_t *rng, int64 center)
+{
+	return getPoissonRandU64(pcg64f_random_r(rng), center);
+}
+
+/* Same as getPoissonRand() but using the given 64-bit random number. */
+int64
+getPoissonRandU64(unsigned long long r, int64 center)
 {
 	/*
 	 * Use inverse transform sampling to generate a value > 0, such that the
@@ -115,7 +178,145 @@ getPoissonRand(pcg64f_random_t *rng, int64 center)
 	double		uniform;
 
 	/* erand in [0, 1), uniform in (0, 1] */
-	uniform = 1.0 - genrand64_real2(rng);
+	uniform = 1.0 - rand64_real2(r);
 
 	return (int64) (-log(uniform) * ((double) center) + 0.5);
 }
+
+/*
+ * random number generator: hotspot distribution from min to max inclusive,
+ * where hot_draws of the values fall in the first hot_keys of the range, both
+ * given as fractions.
+ */
+int64
+getHotspotRand(pcg64f_random_t *rng, int64 min, int64 max, double hot_draws,
+		double hot_keys)
+{
+	return getHotspotRandU64(pcg64f_random_r(rng), min, max, hot_draws,
+			hot_keys);
+}
+
+/* Same as getHotspotRand() but using the given 64-bit random number. */
+int64
+getHotspotRandU64(unsigned long long r, int64 min, int64 max,
+		double hot_draws, double hot_keys)
+{
+	double		uniform;
+	int64		n,
+				hot;
+
+	uniform = rand64_real2(r);
+	n = max - min + 1;
+	hot = (int64) (n * hot_keys);
+	if (hot < 1)
+		hot = 1;
+	if (hot >= n)
+		return min + (int64) (n * uniform);
+
+	/* Stretch whichever part of [0, 1) the number is in across its keys. */
+	if (uniform < hot_draws)
+		return min + (int64) (hot * (uniform / hot_draws));
+	return min + hot + (int64) ((n - hot) *
+			((uniform - hot_draws) / (1.0 - hot_draws)));
+}
+
+/*
+ * Helpers for the rejection-inversion method, computing log1p(x) / x and
+ * expm1(x) / x without losing precision as x gets close to 0.
+ */
+static double
+zipfianHelper1(double x)
+{
+	if (fabs(x) > 1e-8)
+		return log1p(x) / x;
+	return 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+
+static double
+zipfianHelper2(double x)
+{
+	if (fabs(x) > 1e-8)
+		return expm1(x) / x;
+	return 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+}
+
+/* The hat function h(x) = 1 / x^exponent. */
+static double
+zipfianH(const struct zipfian_t *z, double x)
+{
+	return exp(-z->exponent * log(x));
+}
+
+/* The integral of h(x), and its inverse. */
+static double
+zipfianHIntegral(const struct zipfian_t *z, double x)
+{
+	double		log_x = log(x);
+
+	return zipfianHelper2((1.0 - z->exponent) * log_x) * log_x;
+}
+
+static double
+zipfianHIntegralInverse(const struct zipfian_t *z, double x)
+{
+	double		t = x * (1.0 - z->exponent);
+
+	if (t < -1.0)
+		t = -1.0;
+	return exp(zipfianHelper1(t) * x);
+}
+
+/*
+ * Work out the constants for a Zipfian distribution from min to max inclusive,
+ * where the chance of the k-th value is proportional to 1 / k^exponent.
+ */
+void
+setZipfian(struct zipfian_t *z, int64 min, int64 max, double exponent)
+{
+	z->min = min;
+	z->n = max - min + 1;
+	z->exponent = exponent;
+	z->h_integral_x1 = zipfianHIntegral(z, 1.5) - 1.0;
+	z->h_integral_n = zipfianHIntegral(z, z->n + 0.5);
+	z->s = 2.0 - zipfianHIntegralInverse(z,
+			zipfianHIntegral(z, 2.5) - zipfianH(z, 2.0));
+}
+
+/*
+ * random number generator: Zipfian distribution where min is the most likely
+ * value, set up by setZipfian().
+ */
+int64
+getZipfianRand(pcg64f_random_t *rng, const struct zipfian_t *z)
+{
+	return getZipfianRandMix(pcg64f_random_r(rng), z);
+}
+
+/*
+ * Same as getZipfianRand() but the random numbers are derived from the single
+ * seed with splitmix64.  Uses the rejection-inversion method of Hormann and
+ * Derflinger, which takes constant time whatever the range, and accepts the
+ * first try most of the time.
+ */
+int64
+getZipfianRandMix(unsigned long long seed, const struct zipfian_t *z)
+{
+	double		u,
+				x;
+	int64		k;
+
+	while (1)
+	{
+		u = z->h_integral_n + splitmix64_real2(&seed) *
+				(z->h_integral_x1 - z->h_integral_n);
+		x = zipfianHIntegralInverse(z, u);
+		k = (int64) (x + 0.5);
+		if (k < 1)
+			k = 1;
+		else if (k > z->n)
+			k = z->n;
+		if (k - x <= z->s ||
+				u >= zipfianHIntegral(z, k + 0.5) - zipfianH(z, k))
+			return z->min + k - 1;
+	}
+}
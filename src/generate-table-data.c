@@ -2,31 +2,151 @@
  * Copyright 2019 PostgreSQL Global Development Group
  */
 
+/* For O_DIRECT. */
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <libgen.h>
 #include <getopt.h>
 #include <errno.h>
 #include <limits.h>
+#include <math.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/time.h>
+#include <pthread.h>
+#include <linux/io_uring.h>
+#include <zlib.h>
+#include <libpq-fe.h>
 
 #include "config.h"
 #include "touchstone.h"
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 #define MAX_BUFFER_LEN 1024
 #define MAX_COLS 255
 
+/* Number of rows a thread generates before handing them off to be written. */
+#define BLOCK_ROWS 16384
+
+/* Default number of kilobytes to buffer before writing out generated data. */
+#define DEFAULT_FLUSH_KB 4096
+
+#define FORMAT_TEXT 0
+#define FORMAT_PGBINARY 1
+#define FORMAT_COLUMNAR 2
+
+/*
+ * Compressed output is a series of independent gzip members or zstd frames,
+ * one per block written, that decompress as one stream.
+ */
+#define COMPRESS_NONE 0
+#define COMPRESS_GZIP 1
+#define COMPRESS_ZSTD 2
+
+/* How data gets to an output file made with -o. */
+#define IO_WRITE 0
+#define IO_MMAP 1
+#define IO_URING 2
+#define IO_URING_DIRECT 3
+
+/* Buffers the io_uring writer keeps in flight, and their alignment. */
+#define URING_BUFFERS 4
+#define URING_ALIGN 4096
+
+#define DEFAULT_GZIP_LEVEL 6
+#define DEFAULT_ZSTD_LEVEL 3
+
+/* Default seconds between progress reports. */
+#define DEFAULT_PROGRESS_SECONDS 5
+
+/* Default seconds between checkpoints when resuming without -k. */
+#define DEFAULT_CHECKPOINT_SECONDS 60
+
+/*
+ * Domains of the keys a column gets from its table's key, so they are not
+ * the random numbers counter_random() gives the table's rows in version 3.
+ */
+#define KEY_UNIQUE 0x756e69717565ULL
+#define KEY_NULL 0x6e756c6cULL
+#define KEY_DISTINCT 0x64697374696e6374ULL
+
+/* Rows generated a column at a time, and rows in a columnar row group. */
+#define BATCH_ROWS 1024
+#define ROW_GROUP_ROWS (64 * BATCH_ROWS)
+
+/* Kinds of values a column produces when generated a column at a time. */
+#define VALUE_INTEGER 0
+#define VALUE_DATE 1 /* Days since 1970-01-01. */
+#define VALUE_TEXT 2
+#define VALUE_LIST 3 /* Index of the line in the list. */
+#define VALUE_TIMESTAMP 4 /* Microseconds since 1970-01-01. */
+#define VALUE_TIMESTAMPTZ 5 /* Microseconds since 1970-01-01 in UTC. */
+#define VALUE_NUMERIC 6 /* Units of 10^-scale. */
+
+/* PostgreSQL's binary numeric: 4 header fields, and base 10000 digits. */
+#define NUMERIC_BASE 10000
+#define NUMERIC_NEG 0x4000
+#define MAX_NUMERIC_DIGITS 6
+#define VALUE_NULL -1 /* Only used when writing out a NULL. */
+
+/* Encodings of a column chunk in the columnar format. */
+#define ENCODING_PLAIN 0
+#define ENCODING_DICTIONARY 1
+#define ENCODING_NULLS 0x80 /* Flag for a chunk starting with a NULL bitmap. */
+
+/* Larger lists are stored as plain text rather than repeat the dictionary. */
+#define MAX_DICTIONARY_SIZE 4096
+
+#define COLUMNAR_MAGIC "TSCOLUMN"
+#define COLUMNAR_MAGIC_LEN 8
+
+/* Days between the Unix epoch and the PostgreSQL epoch, 2000-01-01. */
+#define POSTGRES_EPOCH_DAYS 10957
+
 #define TYPE_DATE 'd'
 #define TYPE_EXPONENTIAL 'e'
 #define TYPE_GAUSSIAN 'g'
+#define TYPE_HOTSPOT 'h'
 #define TYPE_INTEGER 'i'
 #define TYPE_LIST 'l'
+#define TYPE_WORDS 'm'
 #define TYPE_POISSON 'p'
+#define TYPE_REFERENCE 'r'
 #define TYPE_SEQUENCE 's'
 #define TYPE_TEXT 't'
+#define TYPE_UNIQUE 'u'
+#define TYPE_WEIGHTED_LIST 'w'
+#define TYPE_EXPRESSION 'x'
+#define TYPE_TIMESTAMP 'T'
+#define TYPE_TIMESTAMPTZ 'Z'
+#define TYPE_ZIPFIAN 'z'
+
+#define MAX_WEIGHT_LEN 64
+
+/* Operations of a compiled expression, evaluated on a stack of vectors. */
+#define OP_CONSTANT 0
+#define OP_COLUMN 1
+#define OP_RANDOM 2
+#define OP_NEGATE 3
+#define OP_ADD 4
+#define OP_SUBTRACT 5
+#define OP_MULTIPLY 6
+#define OP_DIVIDE 7
+#define OP_MODULO 8
+
+#define MAX_EXPRESSION_OPS 32
+#define MAX_EXPRESSION_DEPTH 8
 
 struct date_t
 {
@@ -43,6 +163,21 @@ struct exponential_t
 	double arg3;
 };
 
+struct operation_t
+{
+	int code;
+	long long arg1;
+	long long arg2;
+};
+
+/* An expression compiled to postfix operations when the file is read. */
+struct expression_t
+{
+	int ops;
+	int kind; /* VALUE_DATE or VALUE_INTEGER. */
+	struct operation_t op[MAX_EXPRESSION_OPS];
+};
+
 struct gaussian_t
 {
 	long long arg1;
@@ -50,17 +185,36 @@ struct gaussian_t
 	double arg3;
 };
 
+struct hotspot_t
+{
+	long long arg1;
+	long long arg2;
+	double arg3; /* Fraction of values that are hot. */
+	double arg4; /* Fraction of the range that is hot. */
+};
+
 struct integer_t
 {
 	long long arg1;
 	long long arg2;
 };
 
+/*
+ * The whole list file is mapped to memory, with the start and length of each
+ * line indexed so that any line can be picked and copied out directly.
+ */
 struct list_t
 {
 	int size;
 	char filename[FILENAME_MAX];
-	char *line[16];
+	char *arena;
+	size_t arena_size;
+	size_t *offset;
+	int *length;
+	int max_length;
+	/* Alias table for picking lines of a weighted list. */
+	double *probability;
+	int *alias;
 };
 
 struct poisson_t
@@ -68,6 +222,20 @@ struct poisson_t
 	long long arg1;
 };
 
+/*
+ * A reference picks a random row of another table and generates the value
+ * that table has in that row, so the two tables join.
+ */
+struct reference_t
+{
+	char name[FILENAME_MAX];
+	int column;
+	struct table_definition_t *table;
+	pcg64f_random_t rng; /* Seeded like the referenced table's generator. */
+	int draw; /* Random number of a row the referenced column uses. */
+	int multiplier;
+};
+
 struct sequence_t
 {
 	long long arg1;
@@ -79,224 +247,3512 @@ struct text_t
 	int arg2;
 };
 
+struct timestamp_t
+{
+	long long arg1; /* Microseconds since 1970-01-01. */
+	long long arg2;
+};
+
+/*
+ * Text made of the words of a sample text file, read as one sentence per
+ * line.  Each occurrence of a word is indexed under the word before it, so
+ * that one random number picks the next word in proportion to how often it
+ * follows the last one in the sample, as a first order Markov chain.
+ */
+struct words_t
+{
+	struct list_t list; /* The sample text. */
+	int arg1;
+	int arg2;
+	int words; /* Number of distinct words. */
+	size_t *offset; /* Start and length of each distinct word in the arena. */
+	int *length;
+	int *first; /* Where the words following each word start in next. */
+	int *next; /* Word after each occurrence, or -1 at the end of a line. */
+	int starts;
+	int *start; /* First word of each line. */
+};
+
+struct unique_t
+{
+	long long arg1;
+	long long arg2;
+	unsigned long long key; /* Key of the permutation of the range. */
+};
+
 union arguments_t
 {
 	struct date_t date;
 	struct exponential_t exponential;
+	struct expression_t expression;
 	struct gaussian_t gaussian;
+	struct hotspot_t hotspot;
 	struct integer_t integer;
 	struct list_t list;
 	struct poisson_t poisson;
+	struct reference_t reference;
 	struct sequence_t sequence;
+	struct zipfian_t zipfian;
 	struct text_t text;
+	struct timestamp_t timestamp;
+	struct unique_t unique;
+	struct words_t words;
 };
 
 struct column_t
 {
 	char type;
 	union arguments_t arguments;
+	unsigned long long nulls; /* Chance of a NULL out of 2^64, or 0. */
+	long long distinct; /* Number of distinct values, or 0 for any. */
+	unsigned long long null_key;
+	unsigned long long distinct_key;
+	int nullable; /* Has NULLs, or is an expression of a column that does. */
+	int precision; /* Integers are numeric with a scale if this is set. */
+	int scale;
 };
 
 struct table_definition_t
 {
+	int version; /* Version of the data to generate for a given seed. */
+	unsigned long long seed;
+	unsigned long long key; /* Key for counter_random() in version 3 data. */
+	unsigned long long hash; /* Of the definition and the files it reads. */
 	long long rows;
 	int columns;
+	int referenced; /* Only read to be referenced, don't follow references. */
 	struct column_t column[MAX_COLS];
 };
 
+/*
+ * Asynchronous writer copying data into aligned buffers that are written out
+ * with io_uring while the next ones are filled.
+ */
+struct uring_t
+{
+	int ring_fd;
+	int fd;
+	int direct;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_ptr;
+	void *cq_ptr;
+	size_t sq_size;
+	size_t cq_size;
+	size_t sqes_size;
+	size_t buffer_size;
+	char *buffer[URING_BUFFERS];
+	size_t buffer_len[URING_BUFFERS];
+	long long buffer_offset[URING_BUFFERS];
+	int busy[URING_BUFFERS];
+	int current;
+	size_t len; /* Bytes in the current buffer. */
+	long long offset; /* File offset of the current buffer. */
+	int in_flight;
+};
+
+/*
+ * Rows are formatted directly into a user-space buffer that is written out
+ * with write() once it holds at least flush_size bytes.  An fd of -1 means the
+ * buffer is only filled, and it is up to the caller to write it out.
+ *
+ * Rows are either delimited text, or PostgreSQL's binary COPY format where
+ * each row is a 16-bit field count followed by each field's 32-bit length and
+ * value, all in network byte order.
+ */
+struct output_t
+{
+	int format;
+	int fd;
+	size_t flush_size;
+	size_t size;
+	size_t len;
+	char *data;
+	int compress;
+	int level;
+	size_t zsize;
+	size_t zlen;
+	char *zdata; /* Compressed copy of data. */
+	PGconn *conn; /* Send data with COPY instead of writing to fd. */
+	char *map; /* Copy data into fd mapped to memory instead of writing. */
+	size_t map_size;
+	size_t map_len;
+	struct uring_t *uring; /* Write to fd with io_uring if set. */
+	struct checkpoint_t *checkpoint; /* Record the rows written to fd. */
+	struct progress_t *progress; /* Count the rows and time of thread. */
+	int thread;
+};
+
+/*
+ * A checkpoint records how many rows of a data file are written out, and how
+ * long the file is up to there, so that an interrupted run can be resumed by
+ * truncating the file to that length and generating the rest of the rows.
+ */
+struct checkpoint_t
+{
+	char filename[FILENAME_MAX + 16];
+	int fd; /* The data file. */
+	int interval; /* Seconds between checkpoints. */
+	time_t written; /* When the last checkpoint was written. */
+	int resume; /* The data file already has the rows before row. */
+	pcg64f_random_t rng; /* The prng as seeded, before the first row. */
+	int multiplier;
+	unsigned long long seed;
+	int version;
+	int format;
+	int compress;
+	unsigned long long definition; /* Hash of the table definition. */
+	long long first_row;
+	long long last_row;
+	long long row; /* First row that is not written out yet. */
+	long long bytes; /* Length of the data file up to row. */
+	pcg128_t state; /* The prng state at row, as read back. */
+};
+
+/* Where to load data with COPY FROM STDIN instead of writing it out. */
+struct database_t
+{
+	const char *conninfo;
+	char command[FILENAME_MAX + 64];
+};
+
+/* What one thread has done so far, for reporting progress. */
+struct thread_stats_t
+{
+	long long rows;
+	long long bytes;
+	long long generate_ns; /* Generating and compressing rows. */
+	long long wait_ns; /* Waiting for a turn to write. */
+	long long write_ns;
+};
+
+/*
+ * Progress of generating a data file, reported every interval by a thread of
+ * its own so that reports keep coming even while the output is stalled.
+ */
+struct progress_t
+{
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t tid;
+	const char *table;
+	int interval; /* Seconds between reports. */
+	int print; /* Print a progress line to stderr. */
+	int tty; /* Overwrite the progress line instead of adding lines. */
+	FILE *stats; /* Append a CSV line per thread to this, if set. */
+	int done;
+	long long rows; /* Rows to generate. */
+	struct timespec start;
+	double last; /* Seconds from the start to the last report. */
+	int threads;
+	struct thread_stats_t *thread;
+	struct thread_stats_t *reported; /* As of the last report. */
+};
+
+/*
+ * State shared by all threads generating rows in parallel.  Rows are split
+ * into blocks of BLOCK_ROWS that are handed out round-robin to the threads,
+ * and written out in block order so the output is the same as if it was
+ * generated by a single thread.
+ */
+struct parallel_t
+{
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+
+	pcg64f_random_t rng;
+	int format;
+	int fd;
+	size_t flush_size;
+	int compress;
+	int level;
+	struct database_t *database;
+	char *map;
+	size_t map_size;
+	size_t map_len; /* Bytes of the map claimed by blocks so far. */
+	struct uring_t *uring;
+	struct columnar_t *columnar;
+	struct checkpoint_t *checkpoint;
+	struct progress_t *progress;
+	struct table_definition_t *table;
+	char delimiter;
+	int multiplier;
+	int threads;
+	long long block_rows;
+	long long first_row;
+	long long last_row;
+
+	long long next_block; /* Next block to be written out. */
+	int error;
+};
+
+/*
+ * One column's values for a batch of rows.  Numeric values, dates and list
+ * indexes are kept in value, text is kept in one buffer where value i is from
+ * offset[i] to offset[i + 1].
+ */
+struct vector_t
+{
+	int kind;
+	int scale;
+	long long value[BATCH_ROWS];
+	size_t offset[BATCH_ROWS + 1];
+	size_t text_size;
+	char *text;
+	char *null; /* Set for each NULL if the column is nullable. */
+};
+
+/*
+ * A batch of rows generated a column at a time.  For data versions that use
+ * the prng, the random numbers for the whole batch are drawn first in row
+ * order, so that each column can pick out its own regardless of the order the
+ * columns are generated in.
+ */
+struct batch_t
+{
+	long long first_row;
+	int rows;
+	int multiplier;
+	unsigned long long *draws;
+	unsigned long long r[BATCH_ROWS]; /* The current column's numbers. */
+	struct vector_t *vector;
+};
+
+/* A column's data and statistics for the current columnar row group. */
+struct column_chunk_t
+{
+	struct output_t data;
+	int encoding;
+	int has_stats;
+	long long min;
+	long long max;
+	char *min_text;
+	size_t min_len;
+	char *max_text;
+	size_t max_len;
+	unsigned char *nulls; /* Bitmap of NULLs if the column is nullable. */
+};
+
+/* Column chunks collected in memory for a columnar row group. */
+struct row_group_t
+{
+	long long rows;
+	struct column_chunk_t *chunk;
+};
+
+/*
+ * State of the columnar writer.  Row groups are written out one column chunk
+ * after the other, and the location and statistics of each chunk are added to
+ * the footer written at the end.
+ */
+struct columnar_t
+{
+	struct table_definition_t *table;
+	struct output_t *out;
+	long long offset; /* Bytes written to out so far. */
+	int row_groups;
+	struct output_t footer;
+};
+
+/* Options from the command line that apply to every table generated. */
+struct options_t
+{
+	unsigned long long seed;
+	long flush_kb;
+	int chunk;
+	int chunks;
+	long long first_row; /* Range from -r counting from 1, else 0. */
+	long long last_row;
+	int format;
+	int compress;
+	int level;
+	const char *suffix;
+	const char *conninfo; /* Load the database instead of writing out. */
+	int io;
+	int threads;
+	int version;
+	char delimiter;
+	char outdir[FILENAME_MAX];
+	int checkpoint; /* Seconds between checkpoints, or -1 for none. */
+	int resume;
+	int progress; /* Print a progress line. */
+	int interval; /* Seconds between progress reports. */
+	FILE *stats;
+};
+
+struct worker_t
+{
+	pthread_t tid;
+	int id;
+	struct parallel_t *parallel;
+};
+
+int output_flush(struct output_t *);
+int compile_expression(struct table_definition_t *, int, const char *);
+int check_numeric(struct table_definition_t *, int);
+int read_modifiers(struct table_definition_t *, int, char *);
+int read_timestamp(const char *, long long *);
+int read_data_definition_file(struct table_definition_t *, char *);
 int read_list(struct list_t *);
-void sequence(char *, long long);
+int read_reference(struct table_definition_t *, struct reference_t *,
+		char *);
+int read_weights(struct list_t *);
+int read_words(struct words_t *);
 
 void usage(char *filename)
 {
 	printf("usage: %s [options]\n", filename);
 	printf("  options:\n");
+	printf("    -b <int> - kilobytes of data to buffer before writing, "
+			"default: %d\n", DEFAULT_FLUSH_KB);
 	printf("    -c <int> - number of data file chunks to generate, default: "
 			"1\n");
 	printf("    -C <int> - specify which chunk to generate\n");
 	printf("    -d <char> - column delimiter, default <tab>\n");
+	printf("    -D, --dbconn <conninfo> - load the data into the table with "
+			"COPY instead\n");
 	printf("    -f <filename> - data definition file\n");
+	printf("    -F, --format <text|pgbinary|columnar> - output format, "
+			"default: text\n");
+	printf("    -j <int> - number of threads to generate data with, default: "
+			"1\n");
+	printf("    -I, --interval <int> - seconds between progress reports, "
+			"default: %d\n", DEFAULT_PROGRESS_SECONDS);
+	printf("    -k, --checkpoint <int> - with -o, record the rows written "
+			"every <int> seconds, 0 for every write\n");
+	printf("    -M, --mmap - with -o, copy data into the file mapped to "
+			"memory\n");
 	printf("    -o <dir> - location to create data file else use stdout\n");
+	printf("    -P, --progress - show the rows generated and the rates of "
+			"generating and writing\n");
+	printf("    -r <int>,<int> - generate only this range of rows, counting "
+			"from 1\n");
+	printf("    -R, --resume - with -o, continue data files from their "
+			"checkpoints\n");
 	printf("    -s <int> - set seed, default: random\n");
+	printf("    -S, --schema <filename> - generate each data definition file "
+			"listed\n");
+	printf("    -T, --stats <filename> - write the progress of each thread "
+			"as CSV\n");
+	printf("    -U, --uring[=direct] - with -o, write with io_uring, "
+			"optionally with O_DIRECT\n");
+	printf("    -V <int> - version of the data to generate, default: %d\n",
+			DATA_VERSION_1);
+	printf("    -z, --compress <gzip|zstd>[:<level>] - compress the data, "
+			"default levels: %d and %d\n", DEFAULT_GZIP_LEVEL,
+			DEFAULT_ZSTD_LEVEL);
 }
 
-int generate_data(pcg64f_random_t *rng, FILE *stream,
-		struct table_definition_t *table, char delimiter, int chunks, int chunk)
+static inline void put_int16(char *p, int value)
 {
-	char str[MAX_BUFFER_LEN];
-	int end = table->columns - 1;
+	p[0] = (char) (value >> 8);
+	p[1] = (char) value;
+}
 
-	long long chunk_size;
-	long long chunk_start = 0;
-	long long last_row;
-	long long ll;
-	struct tm tm;
-	long long row, col;
+static inline void put_int32(char *p, int value)
+{
+	p[0] = (char) (value >> 24);
+	p[1] = (char) (value >> 16);
+	p[2] = (char) (value >> 8);
+	p[3] = (char) value;
+}
 
-	if (chunks > 1) {
-		int multiplier = 0;
+static inline void put_int64(char *p, long long value)
+{
+	put_int32(p, (int) (value >> 32));
+	put_int32(p + 4, (int) value);
+}
 
-		chunk_size = table->rows / (long long) chunks;
-		chunk_start = (chunk - 1) * chunk_size;
+int output_init(struct output_t *out, int format, int fd, size_t flush_size)
+{
+	out->format = format;
+	out->fd = fd;
+	out->flush_size = flush_size;
+	out->len = 0;
+	out->compress = COMPRESS_NONE;
+	out->level = 0;
+	out->zsize = 0;
+	out->zlen = 0;
+	out->zdata = NULL;
+	out->conn = NULL;
+	out->map = NULL;
+	out->map_size = 0;
+	out->map_len = 0;
+	out->uring = NULL;
+	out->checkpoint = NULL;
+	out->progress = NULL;
+	out->thread = 0;
+	/* Leave room for a row to finish after reaching the flush size. */
+	out->size = flush_size + MAX_BUFFER_LEN;
+	out->data = (char *) malloc(out->size);
+	if (out->data == NULL) {
+		fprintf(stderr, "ERROR: cannot allocate %lu byte output buffer\n",
+				(unsigned long) out->size);
+		return 1;
+	}
+	return 0;
+}
 
-		/* Calculate how far to advanve the prng base on the column types. */
-		for (col = 0; col < table->columns; col++) {
-			switch (table->column[col].type) {
-			case TYPE_DATE:
-			case TYPE_EXPONENTIAL:
-			case TYPE_GAUSSIAN:
-			case TYPE_INTEGER:
-			case TYPE_LIST:
-			case TYPE_POISSON:
-			case TYPE_TEXT:
-				++multiplier;
-				break;
-			case TYPE_SEQUENCE:
-				break;
-			default:
-				fprintf(stderr,
-						"ERROR: unhandled column definition for prng advancing: %c\n",
-						table->column[col].type);
-				return 1;
-			}
-		}
-		pcg64f_advance_r(rng, chunk_start * multiplier);
+/*
+ * Make sure there are at least len more bytes available in the buffer, and
+ * return a pointer to where they start.  The buffer is grown if a single row
+ * does not fit.
+ */
+char *output_reserve(struct output_t *out, size_t len)
+{
+	char *data;
+	size_t size;
 
-		last_row = chunk * chunk_size;
-	}
-	else
-		last_row = table->rows;
+	if (out->len + len <= out->size)
+		return out->data + out->len;
 
-	for (row = chunk_start; row < last_row; row++) {
-		for (col = 0; col < table->columns; col++) {
-			switch (table->column[col].type) {
-			case TYPE_DATE:
-				get_date(rng, &tm,
-						((struct date_t *)
-								&table->column[col].arguments)->tloc1,
-						((struct date_t *)
-								&table->column[col].arguments)->diff);
-				fprintf(stream, "%d-%d-%d", tm.tm_year, tm.tm_mon, tm.tm_mday);
-				break;
-			case TYPE_EXPONENTIAL:
-				ll = getExponentialRand(rng, ((struct exponential_t *)
-								&table->column[col].arguments)->arg1,
-						((struct exponential_t *)
-								&table->column[col].arguments)->arg2,
-						((struct exponential_t *)
-								&table->column[col].arguments)->arg3);
-				fprintf(stream, "%lld", ll);
-				break;
-			case TYPE_GAUSSIAN:
-				ll = getGaussianRand(rng, ((struct gaussian_t *)
-								&table->column[col].arguments)->arg1,
-						((struct gaussian_t *)
-								&table->column[col].arguments)->arg2,
-						((struct gaussian_t *)
-								&table->column[col].arguments)->arg3);
-				fprintf(stream, "%lld", ll);
-				break;
-			case TYPE_INTEGER:
-				ll = getrand(rng, ((struct integer_t *)
-								&table->column[col].arguments)->arg1,
-						((struct integer_t *)
-								&table->column[col].arguments)->arg2);
-				fprintf(stream, "%lld", ll);
-				break;
-			case TYPE_LIST:
-				fprintf(stream, "%s", ((struct list_t *)
-						&table->column[col].arguments)->line[
-								getrand(rng, 0, ((struct list_t *)
-										&table->column[col].arguments)->size -
-												1)]);
-				break;
-			case TYPE_POISSON:
-				ll = getPoissonRand(rng, ((struct poisson_t *)
-								&table->column[col].arguments)->arg1);
-				fprintf(stream, "%lld", ll);
-				break;
-			case TYPE_SEQUENCE:
-				sequence(str, row +
-						((struct sequence_t *)
-								&table->column[col].arguments)->arg1);
-				fprintf(stream, "%s", str);
-				break;
-			case TYPE_TEXT:
-				get_alpha(rng, str,
-						((struct text_t *)
-								&table->column[col].arguments)->arg1,
-						((struct text_t *)
-								&table->column[col].arguments)->arg2);
-				fprintf(stream, "%s", str);
-				break;
-			default:
-				fprintf(stderr, "ERROR: unhandled column definition: %c\n",
-						table->column[col].type);
-				return 1;
-			}
-			if (col < end)
-				fprintf(stream, "%c", delimiter);
-		}
-		fprintf(stream, "\n");
-		fflush(stream);
+	size = out->size * 2;
+	while (size < out->len + len)
+		size *= 2;
+	data = (char *) realloc(out->data, size);
+	if (data == NULL) {
+		fprintf(stderr, "ERROR: cannot grow output buffer to %lu bytes\n",
+				(unsigned long) size);
+		return NULL;
 	}
+	out->data = data;
+	out->size = size;
+
+	return out->data + out->len;
+}
 
+int output_append(struct output_t *out, const char *str, size_t len)
+{
+	char *p = output_reserve(out, len);
+
+	if (p == NULL)
+		return 1;
+	memcpy(p, str, len);
+	out->len += len;
 	return 0;
 }
 
-int read_data_definition_file(struct table_definition_t *table, char *filename)
+/* Integers are written as PostgreSQL int8 in binary format. */
+int output_integer(struct output_t *out, long long value)
 {
-	FILE *f;
-	char *line = NULL;
-	size_t len = 0;
-	ssize_t nread;
-	int *column;
-	int rc;
+	char *p = output_reserve(out, MAX_INTEGER_LEN);
 
-	fprintf(stderr, "reading %s\n", filename);
+	if (p == NULL)
+		return 1;
+	if (out->format == FORMAT_PGBINARY) {
+		put_int32(p, 8);
+		put_int64(p + 4, value);
+		out->len += 12;
+	} else
+		out->len += format_integer(p, value);
+	return 0;
+}
 
-	f = fopen(filename, "r");
-	if (f == NULL) {
-		fprintf(stderr, "ERROR: cannot open data definition file [%d]: %s\n",
-				errno, filename);
+/*
+ * Dates are given as days since 1970-01-01, and written as PostgreSQL date in
+ * binary format.
+ */
+int output_date(struct output_t *out, int days)
+{
+	char *p = output_reserve(out, MAX_DATE_LEN);
+	int year, month, day;
+
+	if (p == NULL)
 		return 1;
+	if (out->format == FORMAT_PGBINARY) {
+		put_int32(p, 4);
+		put_int32(p + 4, days - POSTGRES_EPOCH_DAYS);
+		out->len += 8;
+	} else {
+		civil_from_days(days, &year, &month, &day);
+		out->len += format_date(p, year, month, day);
 	}
+	return 0;
+}
 
-	/* Read just the first line for the table cardinality. */
+/*
+ * Reserve room for a text value of up to len bytes plus a terminating null,
+ * and return where the value should be written.  Call output_text_end() with
+ * the value's actual length once it has been written.
+ */
+char *output_text_start(struct output_t *out, size_t len)
+{
+	char *p = output_reserve(out, len + 5);
 
-	nread = getline(&line, &len, f);
-	if (nread == -1) {
-		fprintf(stderr, "ERROR: no data on first line of ddf?: %d",
-				errno);
-		return 2;
+	if (p != NULL && out->format == FORMAT_PGBINARY)
+		p += 4;
+	return p;
+}
+
+void output_text_end(struct output_t *out, char *p, size_t len)
+{
+	if (out->format == FORMAT_PGBINARY)
+		put_int32(p - 4, (int) len);
+	out->len = p - out->data + len;
+}
+
+int output_text(struct output_t *out, const char *str, size_t len)
+{
+	char *p = output_text_start(out, len);
+
+	if (p == NULL)
+		return 1;
+	memcpy(p, str, len);
+	output_text_end(out, p, len);
+	return 0;
+}
+
+/*
+ * Timestamps are given as microseconds since 1970-01-01, and written as
+ * PostgreSQL timestamp or timestamptz in binary format, which are the same.
+ */
+int output_timestamp(struct output_t *out, long long usec, int tz)
+{
+	char *p = output_reserve(out, MAX_TIMESTAMP_LEN);
+
+	if (p == NULL)
+		return 1;
+	if (out->format == FORMAT_PGBINARY) {
+		put_int32(p, 8);
+		put_int64(p + 4, usec - POSTGRES_EPOCH_DAYS * 86400000000LL);
+		out->len += 12;
+	} else
+		out->len += format_timestamp(p, usec, tz);
+	return 0;
+}
+
+/*
+ * Numerics are given as integers of units of 10^-scale, and written in
+ * PostgreSQL's binary format as base 10000 digits aligned with the decimal
+ * point, without leading or trailing zero digits.
+ */
+int output_numeric(struct output_t *out, long long value, int scale)
+{
+	char *p = output_reserve(out, MAX_NUMERIC_LEN);
+	unsigned __int128 u;
+	short digit[MAX_NUMERIC_DIGITS + 1];
+	int digits = 0;
+	int fraction;
+	int weight;
+	int i;
+
+	if (p == NULL)
+		return 1;
+	if (out->format != FORMAT_PGBINARY) {
+		out->len += format_numeric(p, value, scale);
+		return 0;
 	}
-	errno = 0;
-	table->rows = strtoll(line, NULL, 10);
-	if (errno != 0 || table->rows == 0) {
-		fprintf(stderr, "ERROR: number of rows invalid [errno %d]: %s\n",
-				errno, line);
-		free(line);
-		fclose(f);
-		return 5;
+
+	/* Pad the fraction to whole digits, then take digits from the end. */
+	u = value < 0 ? 0ULL - (unsigned long long) value :
+			(unsigned long long) value;
+	for (i = scale; i % 4 != 0; i++)
+		u *= 10;
+	fraction = i / 4;
+	weight = -fraction - 1;
+	for (; u != 0; u /= NUMERIC_BASE) {
+		++weight;
+		if (digits == 0 && u % NUMERIC_BASE == 0)
+			continue;
+		digit[digits++] = (short) (u % NUMERIC_BASE);
 	}
 
-	fprintf(stderr, "%lld row(s)\n", table->rows);
+	put_int32(p, 8 + digits * 2);
+	put_int16(p + 4, digits);
+	put_int16(p + 6, digits == 0 ? 0 : weight);
+	put_int16(p + 8, value < 0 ? NUMERIC_NEG : 0);
+	put_int16(p + 10, scale);
+	for (i = 0; i < digits; i++)
+		put_int16(p + 12 + i * 2, digit[digits - 1 - i]);
+	out->len += 12 + digits * 2;
+	return 0;
+}
 
-	/* Read the column definition from rest of the file. */
+/* A NULL is written as \\N in text, and with a length of -1 in binary. */
+int output_null(struct output_t *out)
+{
+	char *p;
 
-	fprintf(stderr, "column definitions:\n");
-	while ((nread = getline(&line, &len, f)) != -1) {
-		column = &table->columns;
+	if (out->format != FORMAT_PGBINARY)
+		return output_append(out, "\\N", 2);
 
-		if (nread == 0) {
-			fprintf(stderr, "ERROR: empty line in data definition file file, "
-					"aborting\n");
-			free(line);
-			fclose(f);
-			return 4;
-		}
+	p = output_reserve(out, 4);
+	if (p == NULL)
+		return 1;
+	put_int32(p, -1);
+	out->len += 4;
+	return 0;
+}
 
-		fprintf(stderr, "[%d] %s", table->columns + 1, line);
+int output_row_start(struct output_t *out, int columns)
+{
+	char *p;
+
+	if (out->format != FORMAT_PGBINARY)
+		return 0;
+
+	p = output_reserve(out, 2);
+	if (p == NULL)
+		return 1;
+	put_int16(p, columns);
+	out->len += 2;
+	return 0;
+}
+
+int output_row_end(struct output_t *out)
+{
+	if (out->format == FORMAT_PGBINARY)
+		return 0;
+	return output_append(out, "\n", 1);
+}
+
+/* The binary format has a signature, flags and header extension length. */
+int output_header(struct output_t *out)
+{
+	if (out->format != FORMAT_PGBINARY)
+		return 0;
+	return output_append(out, "PGCOPY\n\377\r\n\0\0\0\0\0\0\0\0\0", 19);
+}
+
+/* The binary format ends with a field count of -1. */
+int output_trailer(struct output_t *out)
+{
+	if (out->format != FORMAT_PGBINARY)
+		return 0;
+	return output_append(out, "\377\377", 2);
+}
+
+int write_data(int fd, const char *data, size_t len)
+{
+	ssize_t rc;
+
+	while (len > 0) {
+		rc = write(fd, data, len);
+		if (rc == -1) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "ERROR: cannot write data [%d]\n", errno);
+			return 1;
+		}
+		data += rc;
+		len -= rc;
+	}
+	return 0;
+}
+
+/*
+ * Set up an io_uring instance for writing to fd, bypassing the page cache if
+ * direct is set.  Returns 1 if io_uring cannot be used, so that the caller can
+ * fall back to write().
+ */
+int uring_init(struct uring_t *u, int fd, size_t flush_size, int direct)
+{
+	struct io_uring_params p;
+	struct io_uring_probe *probe;
+	int flags;
+	int i;
+
+	memset(u, 0, sizeof(struct uring_t));
+	u->fd = fd;
+	u->ring_fd = -1;
+	u->offset = lseek(fd, 0, SEEK_CUR);
+	if (u->offset == -1) {
+		fprintf(stderr, "NOTICE: cannot use io_uring, output not seekable\n");
+		return 1;
+	}
+
+	memset(&p, 0, sizeof(struct io_uring_params));
+	u->ring_fd = (int) syscall(__NR_io_uring_setup, URING_BUFFERS, &p);
+	if (u->ring_fd == -1) {
+		fprintf(stderr, "NOTICE: cannot use io_uring [%d]\n", errno);
+		return 1;
+	}
+
+	/* Kernels before 5.6 set up a ring but cannot write with it. */
+	probe = (struct io_uring_probe *) calloc(1, sizeof(struct io_uring_probe) +
+			(IORING_OP_WRITE + 1) * sizeof(struct io_uring_probe_op));
+	if (probe == NULL) {
+		fprintf(stderr, "ERROR: cannot allocate io_uring probe\n");
+		return 1;
+	}
+	if (syscall(__NR_io_uring_register, u->ring_fd, IORING_REGISTER_PROBE,
+			probe, IORING_OP_WRITE + 1) == -1 ||
+			probe->last_op < IORING_OP_WRITE ||
+			!(probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED)) {
+		fprintf(stderr, "NOTICE: cannot use io_uring, writes not "
+				"supported\n");
+		free(probe);
+		return 1;
+	}
+	free(probe);
+
+	u->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	u->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	u->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (u->cq_size > u->sq_size)
+			u->sq_size = u->cq_size;
+		u->cq_size = u->sq_size;
+	}
+	u->sq_ptr = mmap(NULL, u->sq_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, u->ring_fd, IORING_OFF_SQ_RING);
+	if (u->sq_ptr == MAP_FAILED) {
+		u->sq_ptr = NULL;
+		fprintf(stderr, "NOTICE: cannot map io_uring [%d]\n", errno);
+		return 1;
+	}
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		u->cq_ptr = u->sq_ptr;
+	else {
+		u->cq_ptr = mmap(NULL, u->cq_size, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, u->ring_fd, IORING_OFF_CQ_RING);
+		if (u->cq_ptr == MAP_FAILED) {
+			u->cq_ptr = NULL;
+			fprintf(stderr, "NOTICE: cannot map io_uring [%d]\n", errno);
+			return 1;
+		}
+	}
+	u->sqes = (struct io_uring_sqe *) mmap(NULL, u->sqes_size,
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->ring_fd,
+			IORING_OFF_SQES);
+	if (u->sqes == MAP_FAILED) {
+		u->sqes = NULL;
+		fprintf(stderr, "NOTICE: cannot map io_uring [%d]\n", errno);
+		return 1;
+	}
+
+	u->sq_tail = (unsigned *) ((char *) u->sq_ptr + p.sq_off.tail);
+	u->sq_mask = (unsigned *) ((char *) u->sq_ptr + p.sq_off.ring_mask);
+	u->sq_array = (unsigned *) ((char *) u->sq_ptr + p.sq_off.array);
+	u->cq_head = (unsigned *) ((char *) u->cq_ptr + p.cq_off.head);
+	u->cq_tail = (unsigned *) ((char *) u->cq_ptr + p.cq_off.tail);
+	u->cq_mask = (unsigned *) ((char *) u->cq_ptr + p.cq_off.ring_mask);
+	u->cqes = (struct io_uring_cqe *) ((char *) u->cq_ptr + p.cq_off.cqes);
+
+	/* Direct I/O needs aligned buffers, lengths and offsets. */
+	u->buffer_size = (flush_size + URING_ALIGN - 1) &
+			~(size_t) (URING_ALIGN - 1);
+	for (i = 0; i < URING_BUFFERS; i++)
+		if (posix_memalign((void **) &u->buffer[i], URING_ALIGN,
+				u->buffer_size) != 0) {
+			u->buffer[i] = NULL;
+			fprintf(stderr, "ERROR: cannot allocate %lu byte io_uring "
+					"buffer\n", (unsigned long) u->buffer_size);
+			return 1;
+		}
+
+	if (direct) {
+		flags = fcntl(fd, F_GETFL);
+		if (u->offset % URING_ALIGN != 0 ||
+				fcntl(fd, F_SETFL, flags | O_DIRECT) == -1)
+			fprintf(stderr, "NOTICE: cannot use direct I/O, writing through "
+					"the page cache\n");
+		else
+			u->direct = 1;
+	}
+
+	return 0;
+}
+
+/* Turn off direct I/O to write data that is not aligned. */
+int uring_buffered(struct uring_t *u)
+{
+	if (!u->direct)
+		return 0;
+	u->direct = 0;
+	if (fcntl(u->fd, F_SETFL, fcntl(u->fd, F_GETFL) & ~O_DIRECT) == -1) {
+		fprintf(stderr, "ERROR: cannot turn off direct I/O [%d]\n", errno);
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Write what is left of a buffer that was only partly written.  The rest
+ * starts at an unaligned offset, so direct I/O is turned off for it and for
+ * what is written after it.
+ */
+int uring_write_rest(struct uring_t *u, int i, size_t written)
+{
+	const char *data = u->buffer[i] + written;
+	size_t len = u->buffer_len[i] - written;
+	off_t offset = u->buffer_offset[i] + written;
+	ssize_t rc;
+
+	if (uring_buffered(u) != 0)
+		return 1;
+	while (len > 0) {
+		rc = pwrite(u->fd, data, len, offset);
+		if (rc == -1) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "ERROR: cannot write data [%d]\n", errno);
+			return 1;
+		}
+		data += rc;
+		len -= rc;
+		offset += rc;
+	}
+	return 0;
+}
+
+/* Wait for a write to complete. */
+int uring_reap(struct uring_t *u)
+{
+	struct io_uring_cqe *cqe;
+	unsigned head = *u->cq_head;
+	int res;
+	int i;
+
+	while (head == __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE))
+		if (syscall(__NR_io_uring_enter, u->ring_fd, 0, 1,
+				IORING_ENTER_GETEVENTS, NULL, 0) == -1 && errno != EINTR) {
+			fprintf(stderr, "ERROR: cannot wait for io_uring [%d]\n", errno);
+			return 1;
+		}
+
+	cqe = &u->cqes[head & *u->cq_mask];
+	i = (int) cqe->user_data;
+	res = cqe->res;
+	__atomic_store_n(u->cq_head, head + 1, __ATOMIC_RELEASE);
+	u->busy[i] = 0;
+	--u->in_flight;
+
+	if (res < 0) {
+		fprintf(stderr, "ERROR: cannot write data [%d]\n", -res);
+		return 1;
+	}
+	if ((size_t) res < u->buffer_len[i])
+		return uring_write_rest(u, i, res);
+	return 0;
+}
+
+/* Queue len bytes of the current buffer to be written. */
+int uring_submit(struct uring_t *u, size_t len)
+{
+	struct io_uring_sqe *sqe;
+	unsigned tail = *u->sq_tail;
+	unsigned index = tail & *u->sq_mask;
+	int i = u->current;
+
+	u->buffer_len[i] = len;
+	u->buffer_offset[i] = u->offset;
+	u->busy[i] = 1;
+	++u->in_flight;
+
+	sqe = &u->sqes[index];
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	sqe->opcode = IORING_OP_WRITE;
+	sqe->fd = u->fd;
+	sqe->addr = (unsigned long) u->buffer[i];
+	sqe->len = len;
+	sqe->off = u->offset;
+	sqe->user_data = i;
+	u->sq_array[index] = index;
+	__atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	while (syscall(__NR_io_uring_enter, u->ring_fd, 1, 0, 0, NULL, 0) == -1)
+		if (errno != EINTR) {
+			fprintf(stderr, "ERROR: cannot submit to io_uring [%d]\n", errno);
+			return 1;
+		}
+
+	u->offset += len;
+	return 0;
+}
+
+/*
+ * Copy data into the current buffer, handing each full buffer to io_uring and
+ * moving on to the next one once its earlier write is done.
+ */
+int uring_write(struct uring_t *u, const char *data, size_t len)
+{
+	size_t n;
+
+	while (len > 0) {
+		n = u->buffer_size - u->len;
+		if (n > len)
+			n = len;
+		memcpy(u->buffer[u->current] + u->len, data, n);
+		u->len += n;
+		data += n;
+		len -= n;
+
+		if (u->len < u->buffer_size)
+			break;
+		if (uring_submit(u, u->len) != 0)
+			return 1;
+		u->current = (u->current + 1) % URING_BUFFERS;
+		u->len = 0;
+		while (u->busy[u->current])
+			if (uring_reap(u) != 0)
+				return 1;
+	}
+	return 0;
+}
+
+/*
+ * Write out the last partial buffer and wait for everything in flight.  Direct
+ * I/O is turned off for an unaligned tail.
+ */
+int uring_finish(struct uring_t *u)
+{
+	size_t aligned = u->len;
+	int i = u->current;
+	int rc = 0;
+
+	if (u->direct)
+		aligned &= ~(size_t) (URING_ALIGN - 1);
+	if (aligned > 0)
+		rc = uring_submit(u, aligned);
+	while (u->in_flight > 0)
+		if (uring_reap(u) != 0)
+			rc = 1;
+
+	if (rc == 0 && aligned < u->len) {
+		u->buffer_len[i] = u->len;
+		u->buffer_offset[i] = u->offset - aligned;
+		rc = uring_write_rest(u, i, aligned);
+		u->offset += u->len - aligned;
+	}
+	u->len = 0;
+
+	return rc;
+}
+
+void uring_free(struct uring_t *u)
+{
+	int i;
+
+	for (i = 0; i < URING_BUFFERS; i++)
+		free(u->buffer[i]);
+	if (u->sqes != NULL)
+		munmap(u->sqes, u->sqes_size);
+	if (u->cq_ptr != NULL && u->cq_ptr != u->sq_ptr)
+		munmap(u->cq_ptr, u->cq_size);
+	if (u->sq_ptr != NULL)
+		munmap(u->sq_ptr, u->sq_size);
+	if (u->ring_fd != -1)
+		close(u->ring_fd);
+}
+
+/*
+ * Send data to a COPY in progress.  The connection is blocking, so this waits
+ * for the server to catch up when libpq cannot buffer any more.
+ */
+int copy_data(PGconn *conn, const char *data, size_t len)
+{
+	int n;
+
+	while (len > 0) {
+		n = len > INT_MAX ? INT_MAX : (int) len;
+		if (PQputCopyData(conn, data, n) != 1) {
+			fprintf(stderr, "ERROR: cannot send COPY data: %s",
+					PQerrorMessage(conn));
+			return 1;
+		}
+		data += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/* Connect and start a COPY FROM STDIN for the output to be sent to. */
+int copy_start(struct output_t *out, struct database_t *database)
+{
+	PGresult *res;
+
+	out->conn = PQconnectdb(database->conninfo);
+	if (PQstatus(out->conn) != CONNECTION_OK) {
+		fprintf(stderr, "ERROR: cannot connect to database: %s",
+				PQerrorMessage(out->conn));
+		PQfinish(out->conn);
+		out->conn = NULL;
+		return 1;
+	}
+
+	res = PQexec(out->conn, database->command);
+	if (PQresultStatus(res) != PGRES_COPY_IN) {
+		fprintf(stderr, "ERROR: cannot start COPY: %s",
+				PQerrorMessage(out->conn));
+		PQclear(res);
+		PQfinish(out->conn);
+		out->conn = NULL;
+		return 1;
+	}
+	PQclear(res);
+
+	return output_header(out);
+}
+
+/*
+ * Finish the COPY and disconnect.  The COPY is aborted if rc says generating
+ * the data failed.
+ */
+int copy_end(struct output_t *out, int rc)
+{
+	PGresult *res;
+
+	if (rc == 0)
+		rc = output_trailer(out);
+	if (rc == 0)
+		rc = output_flush(out);
+
+	if (PQputCopyEnd(out->conn, rc == 0 ? NULL : "data generation failed") !=
+			1) {
+		fprintf(stderr, "ERROR: cannot end COPY: %s",
+				PQerrorMessage(out->conn));
+		rc = 1;
+	}
+	while ((res = PQgetResult(out->conn)) != NULL) {
+		if (rc == 0 && PQresultStatus(res) != PGRES_COMMAND_OK) {
+			fprintf(stderr, "ERROR: COPY failed: %s",
+					PQerrorMessage(out->conn));
+			rc = 1;
+		}
+		PQclear(res);
+	}
+
+	PQfinish(out->conn);
+	out->conn = NULL;
+	return rc;
+}
+
+/*
+ * Size the file to hold at most size bytes of data and map it to memory, so
+ * that threads can copy their blocks straight into it.
+ */
+int output_map_open(struct output_t *out, size_t size)
+{
+	if (ftruncate(out->fd, size) == -1) {
+		fprintf(stderr, "ERROR: cannot size the data file [%d]\n", errno);
+		return 1;
+	}
+	out->map = (char *) mmap(NULL, size, PROT_WRITE, MAP_SHARED, out->fd, 0);
+	if (out->map == MAP_FAILED) {
+		fprintf(stderr, "ERROR: cannot map the data file [%d]\n", errno);
+		out->map = NULL;
+		return 1;
+	}
+	out->map_size = size;
+	out->map_len = 0;
+	return 0;
+}
+
+/* Unmap the file and cut it down to the data actually written. */
+int output_map_close(struct output_t *out)
+{
+	int rc = 0;
+
+	if (munmap(out->map, out->map_size) == -1) {
+		fprintf(stderr, "ERROR: cannot unmap the data file [%d]\n", errno);
+		rc = 1;
+	}
+	if (ftruncate(out->fd, out->map_len) == -1) {
+		fprintf(stderr, "ERROR: cannot size the data file [%d]\n", errno);
+		rc = 1;
+	}
+	out->map = NULL;
+	return rc;
+}
+
+void output_free(struct output_t *out)
+{
+	free(out->data);
+	free(out->zdata);
+}
+
+int compress_gzip(struct output_t *out)
+{
+	z_stream z;
+	int rc;
+
+	memset(&z, 0, sizeof(z_stream));
+	/* Adding 16 to the window bits asks for a gzip header and trailer. */
+	if (deflateInit2(&z, out->level, Z_DEFLATED, 15 + 16, 8,
+			Z_DEFAULT_STRATEGY) != Z_OK) {
+		fprintf(stderr, "ERROR: cannot initialize gzip compression\n");
+		return 1;
+	}
+	out->zlen = deflateBound(&z, out->len);
+	if (out->zlen > out->zsize) {
+		free(out->zdata);
+		out->zsize = out->zlen;
+		out->zdata = (char *) malloc(out->zsize);
+		if (out->zdata == NULL) {
+			fprintf(stderr,
+					"ERROR: cannot allocate %lu byte compression buffer\n",
+					(unsigned long) out->zsize);
+			deflateEnd(&z);
+			return 1;
+		}
+	}
+
+	z.next_in = (Bytef *) out->data;
+	z.avail_in = out->len;
+	z.next_out = (Bytef *) out->zdata;
+	z.avail_out = out->zsize;
+	rc = deflate(&z, Z_FINISH);
+	out->zlen = out->zsize - z.avail_out;
+	deflateEnd(&z);
+	if (rc != Z_STREAM_END) {
+		fprintf(stderr, "ERROR: cannot gzip data [%d]\n", rc);
+		return 1;
+	}
+	return 0;
+}
+
+#ifdef HAVE_ZSTD
+int compress_zstd(struct output_t *out)
+{
+	size_t rc;
+
+	out->zlen = ZSTD_compressBound(out->len);
+	if (out->zlen > out->zsize) {
+		free(out->zdata);
+		out->zsize = out->zlen;
+		out->zdata = (char *) malloc(out->zsize);
+		if (out->zdata == NULL) {
+			fprintf(stderr,
+					"ERROR: cannot allocate %lu byte compression buffer\n",
+					(unsigned long) out->zsize);
+			return 1;
+		}
+	}
+
+	rc = ZSTD_compress(out->zdata, out->zsize, out->data, out->len,
+			out->level);
+	if (ZSTD_isError(rc)) {
+		fprintf(stderr, "ERROR: cannot zstd data: %s\n",
+				ZSTD_getErrorName(rc));
+		return 1;
+	}
+	out->zlen = rc;
+	return 0;
+}
+#endif /* HAVE_ZSTD */
+
+/*
+ * Compress the buffered data into zdata as a complete gzip member or zstd
+ * frame.  Threads call this on their own blocks before waiting for their turn
+ * to write.
+ */
+int output_compress(struct output_t *out)
+{
+	switch (out->compress) {
+	case COMPRESS_GZIP:
+		return compress_gzip(out);
+#ifdef HAVE_ZSTD
+	case COMPRESS_ZSTD:
+		return compress_zstd(out);
+#endif /* HAVE_ZSTD */
+	default:
+		fprintf(stderr, "ERROR: unsupported compression %d\n",
+				out->compress);
+		return 1;
+	}
+}
+
+/* Write out the buffered data, or its compressed copy if already made. */
+int output_write(struct output_t *out, int fd)
+{
+	if (out->map != NULL) {
+		if (out->map_len + out->len > out->map_size) {
+			fprintf(stderr, "ERROR: data exceeds the mapped file size\n");
+			return 1;
+		}
+		memcpy(out->map + out->map_len, out->data, out->len);
+		out->map_len += out->len;
+		return 0;
+	}
+	if (out->conn != NULL)
+		return copy_data(out->conn, out->data, out->len);
+	if (out->uring != NULL) {
+		if (out->compress == COMPRESS_NONE)
+			return uring_write(out->uring, out->data, out->len);
+		return uring_write(out->uring, out->zdata, out->zlen);
+	}
+	if (out->compress == COMPRESS_NONE)
+		return write_data(fd, out->data, out->len);
+	return write_data(fd, out->zdata, out->zlen);
+}
+
+/* Return the nanoseconds since t, and move t up to now. */
+static inline long long lap(struct timespec *t)
+{
+	struct timespec now;
+	long long ns;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ns = (now.tv_sec - t->tv_sec) * 1000000000LL + now.tv_nsec - t->tv_nsec;
+	*t = now;
+	return ns;
+}
+
+/* Add to what a thread has done, if progress is being reported. */
+void progress_add(struct progress_t *progress, int thread, long long rows,
+		long long bytes, long long generate_ns, long long wait_ns,
+		long long write_ns)
+{
+	struct thread_stats_t *stats;
+
+	if (progress == NULL)
+		return;
+
+	pthread_mutex_lock(&progress->lock);
+	stats = &progress->thread[thread];
+	stats->rows += rows;
+	stats->bytes += bytes;
+	stats->generate_ns += generate_ns;
+	stats->wait_ns += wait_ns;
+	stats->write_ns += write_ns;
+	pthread_mutex_unlock(&progress->lock);
+}
+
+int output_flush(struct output_t *out)
+{
+	struct timespec t;
+	long long compress_ns = 0;
+	size_t len;
+	int rc = 0;
+
+	if (out->progress != NULL)
+		clock_gettime(CLOCK_MONOTONIC, &t);
+	if (out->compress != COMPRESS_NONE) {
+		/* Don't bother with empty gzip members or zstd frames. */
+		if (out->len == 0)
+			return 0;
+		rc = output_compress(out);
+		if (out->progress != NULL)
+			compress_ns = lap(&t);
+	}
+	if (rc == 0)
+		rc = output_write(out, out->fd);
+
+	len = out->compress == COMPRESS_NONE ? out->len : out->zlen;
+	if (out->progress != NULL)
+		progress_add(out->progress, out->thread, 0, len, compress_ns, 0,
+				lap(&t));
+	out->len = 0;
+	return rc;
+}
+
+/*
+ * Record that the rows before row are written out, if the interval has passed
+ * since the last checkpoint or force is set.  The data is synced first so the
+ * checkpoint never claims more than is on disk, and the checkpoint replaces
+ * the last one with a rename so there is always a whole one to resume from.
+ */
+int checkpoint_write(struct checkpoint_t *checkpoint, long long row,
+		int force)
+{
+	char tmp[FILENAME_MAX + 20];
+	pcg64f_random_t rng;
+	time_t now = time(NULL);
+	off_t bytes;
+	FILE *f;
+
+	if (checkpoint == NULL ||
+			(!force && now - checkpoint->written < checkpoint->interval))
+		return 0;
+
+	bytes = lseek(checkpoint->fd, 0, SEEK_CUR);
+	if (bytes == -1 || fdatasync(checkpoint->fd) == -1) {
+		fprintf(stderr, "ERROR: cannot sync data for checkpoint [%d]\n",
+				errno);
+		return 1;
+	}
+
+	/* The prng state at the row, to check the table is the same to resume. */
+	rng = checkpoint->rng;
+	pcg64f_advance_r(&rng, row * checkpoint->multiplier);
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", checkpoint->filename);
+	f = fopen(tmp, "w");
+	if (f == NULL) {
+		fprintf(stderr, "ERROR: cannot open checkpoint [%d]: %s\n", errno,
+				tmp);
+		return 1;
+	}
+	fprintf(f, "seed: %llu\n", checkpoint->seed);
+	fprintf(f, "version: %d\n", checkpoint->version);
+	fprintf(f, "format: %d\n", checkpoint->format);
+	fprintf(f, "compress: %d\n", checkpoint->compress);
+	fprintf(f, "definition: %016llx\n", checkpoint->definition);
+	fprintf(f, "first row: %lld\n", checkpoint->first_row);
+	fprintf(f, "last row: %lld\n", checkpoint->last_row);
+	fprintf(f, "row: %lld\n", row);
+	fprintf(f, "bytes: %lld\n", (long long) bytes);
+	fprintf(f, "state: %016llx%016llx\n",
+			(unsigned long long) (rng.state >> 64),
+			(unsigned long long) rng.state);
+	if (fflush(f) != 0 || fsync(fileno(f)) == -1) {
+		fprintf(stderr, "ERROR: cannot write checkpoint [%d]: %s\n", errno,
+				tmp);
+		fclose(f);
+		return 1;
+	}
+	fclose(f);
+	if (rename(tmp, checkpoint->filename) == -1) {
+		fprintf(stderr, "ERROR: cannot rename checkpoint [%d]: %s\n", errno,
+				checkpoint->filename);
+		return 1;
+	}
+
+	checkpoint->written = now;
+	checkpoint->row = row;
+	checkpoint->bytes = bytes;
+	return 0;
+}
+
+/*
+ * Read the checkpoint of a data file to resume from.  Returns -1 if there is
+ * no checkpoint, so the data file is generated from the start.
+ */
+int checkpoint_read(struct checkpoint_t *checkpoint)
+{
+	unsigned long long high, low;
+	FILE *f;
+	int rc;
+
+	f = fopen(checkpoint->filename, "r");
+	if (f == NULL) {
+		if (errno == ENOENT)
+			return -1;
+		fprintf(stderr, "ERROR: cannot open checkpoint [%d]: %s\n", errno,
+				checkpoint->filename);
+		return 1;
+	}
+	rc = fscanf(f, "seed: %llu version: %d format: %d compress: %d "
+			"definition: %llx first row: %lld last row: %lld "
+			"row: %lld bytes: %lld state: %16llx%16llx",
+			&checkpoint->seed, &checkpoint->version, &checkpoint->format,
+			&checkpoint->compress, &checkpoint->definition,
+			&checkpoint->first_row, &checkpoint->last_row,
+			&checkpoint->row, &checkpoint->bytes, &high, &low);
+	fclose(f);
+	if (rc != 11) {
+		fprintf(stderr, "ERROR: invalid checkpoint: %s\n",
+				checkpoint->filename);
+		return 1;
+	}
+	checkpoint->state = ((pcg128_t) high << 64) | low;
+
+	return 0;
+}
+
+/* Add len bytes of data to an FNV-1a hash. */
+unsigned long long hash_bytes(unsigned long long hash, const void *data,
+		size_t len)
+{
+	const unsigned char *p = (const unsigned char *) data;
+
+	while (len-- > 0) {
+		hash ^= *p++;
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+/* FNV-1a hash of a table name, to tell tables apart in version 3 data. */
+unsigned long long hash_name(const char *name)
+{
+	return hash_bytes(0xcbf29ce484222325ULL, name, strlen(name));
+}
+
+/*
+ * Return how many numbers the prng produces per row, so that it can be
+ * advanced to the start of any row.  Returns -1 if the table contains a column
+ * type that is not handled.
+ */
+int prng_multiplier(struct table_definition_t *table)
+{
+	int multiplier = 0;
+	int col;
+
+	for (col = 0; col < table->columns; col++) {
+		switch (table->column[col].type) {
+		case TYPE_DATE:
+		case TYPE_EXPONENTIAL:
+		case TYPE_EXPRESSION:
+		case TYPE_GAUSSIAN:
+		case TYPE_HOTSPOT:
+		case TYPE_INTEGER:
+		case TYPE_LIST:
+		case TYPE_POISSON:
+		case TYPE_REFERENCE:
+		case TYPE_TEXT:
+		case TYPE_TIMESTAMP:
+		case TYPE_TIMESTAMPTZ:
+		case TYPE_WEIGHTED_LIST:
+		case TYPE_WORDS:
+		case TYPE_ZIPFIAN:
+			++multiplier;
+			break;
+		case TYPE_SEQUENCE:
+		case TYPE_UNIQUE:
+			break;
+		default:
+			fprintf(stderr,
+					"ERROR: unhandled column definition for prng advancing: %c\n",
+					table->column[col].type);
+			return -1;
+		}
+	}
+
+	return multiplier;
+}
+
+/*
+ * Return the type of a column's values, a reference has its column's type and
+ * an expression of dates is a date.
+ */
+static inline char value_type(struct table_definition_t *table, int col)
+{
+	struct reference_t *ref;
+
+	switch (table->column[col].type) {
+	case TYPE_EXPRESSION:
+		return ((struct expression_t *)
+				&table->column[col].arguments)->kind == VALUE_DATE ?
+				TYPE_DATE : TYPE_EXPRESSION;
+	case TYPE_REFERENCE:
+		ref = (struct reference_t *) &table->column[col].arguments;
+		/* References of a table only read to be referenced aren't followed. */
+		if (ref->table == NULL)
+			return TYPE_REFERENCE;
+		return ref->table->column[ref->column].type;
+	default:
+		return table->column[col].type;
+	}
+}
+
+/* Return the most bytes a row of the table can take in the output format. */
+size_t row_size_bound(struct table_definition_t *table, int format)
+{
+	size_t size;
+	size_t value;
+	int col;
+
+	/* Binary rows start with a field count, text rows end with a newline. */
+	size = format == FORMAT_PGBINARY ? 2 : 1;
+	for (col = 0; col < table->columns; col++) {
+		switch (value_type(table, col)) {
+		case TYPE_DATE:
+			value = format == FORMAT_PGBINARY ? 4 : MAX_DATE_LEN;
+			break;
+		case TYPE_TIMESTAMP:
+		case TYPE_TIMESTAMPTZ:
+			value = format == FORMAT_PGBINARY ? 8 : MAX_TIMESTAMP_LEN;
+			break;
+		case TYPE_LIST:
+		case TYPE_WEIGHTED_LIST:
+			value = ((struct list_t *)
+					&table->column[col].arguments)->max_length;
+			break;
+		case TYPE_TEXT:
+			value = ((struct text_t *) &table->column[col].arguments)->arg2;
+			break;
+		case TYPE_WORDS:
+			value = ((struct words_t *) &table->column[col].arguments)->arg2;
+			break;
+		default:
+			value = format == FORMAT_PGBINARY ? 8 : MAX_INTEGER_LEN;
+			break;
+		}
+		if (table->column[col].precision != 0)
+			value = format == FORMAT_PGBINARY ?
+					8 + 2 * MAX_NUMERIC_DIGITS :
+					MAX_NUMERIC_LEN;
+		if (table->column[col].nullable && value < 2)
+			value = 2;
+		/* Add the field length in binary, and the delimiter in text. */
+		size += value + (format == FORMAT_PGBINARY ? 4 : 1);
+	}
+
+	return size;
+}
+
+int batch_init(struct batch_t *batch, struct table_definition_t *table,
+		int multiplier)
+{
+	int col;
+
+	memset(batch, 0, sizeof(struct batch_t));
+	batch->multiplier = multiplier;
+	batch->draws = (unsigned long long *) malloc(
+			sizeof(unsigned long long) * BATCH_ROWS * (multiplier + 1));
+	batch->vector = (struct vector_t *) calloc(table->columns,
+			sizeof(struct vector_t));
+	if (batch->draws == NULL || batch->vector == NULL) {
+		fprintf(stderr, "ERROR: cannot allocate memory for a batch of rows\n");
+		return 1;
+	}
+
+	for (col = 0; col < table->columns; col++) {
+		switch (value_type(table, col)) {
+		case TYPE_DATE:
+			batch->vector[col].kind = VALUE_DATE;
+			break;
+		case TYPE_TIMESTAMP:
+			batch->vector[col].kind = VALUE_TIMESTAMP;
+			break;
+		case TYPE_TIMESTAMPTZ:
+			batch->vector[col].kind = VALUE_TIMESTAMPTZ;
+			break;
+		case TYPE_LIST:
+		case TYPE_WEIGHTED_LIST:
+			batch->vector[col].kind = VALUE_LIST;
+			break;
+		case TYPE_TEXT:
+			batch->vector[col].kind = VALUE_TEXT;
+			/* get_alpha() needs room for the terminating null too. */
+			batch->vector[col].text_size = BATCH_ROWS *
+					(((struct text_t *)
+							&table->column[col].arguments)->arg2 + 1);
+			break;
+		case TYPE_WORDS:
+			batch->vector[col].kind = VALUE_TEXT;
+			batch->vector[col].text_size = BATCH_ROWS *
+					((struct words_t *) &table->column[col].arguments)->arg2;
+			break;
+		default:
+			batch->vector[col].kind = VALUE_INTEGER;
+			break;
+		}
+		if (batch->vector[col].kind == VALUE_TEXT) {
+			batch->vector[col].text =
+					(char *) malloc(batch->vector[col].text_size + 1);
+			if (batch->vector[col].text == NULL) {
+				fprintf(stderr,
+						"ERROR: cannot allocate memory for text column %d\n",
+						col + 1);
+				return 1;
+			}
+		}
+		if (table->column[col].precision != 0) {
+			batch->vector[col].kind = VALUE_NUMERIC;
+			batch->vector[col].scale = table->column[col].scale;
+		}
+
+		if (table->column[col].nullable) {
+			batch->vector[col].null = (char *) malloc(BATCH_ROWS);
+			if (batch->vector[col].null == NULL) {
+				fprintf(stderr,
+						"ERROR: cannot allocate memory for NULLs of column "
+						"%d\n", col + 1);
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+void batch_free(struct batch_t *batch, struct table_definition_t *table)
+{
+	int col;
+
+	if (batch->vector != NULL)
+		for (col = 0; col < table->columns; col++) {
+			free(batch->vector[col].text);
+			free(batch->vector[col].null);
+		}
+	free(batch->vector);
+	free(batch->draws);
+}
+
+/*
+ * Pick a line of a weighted list with the alias method: the high bits of the
+ * product of the random number and the list size choose a line, the low bits
+ * choose between that line and its alias.
+ */
+static inline long long pick_weighted(struct list_t *list,
+		unsigned long long r)
+{
+	unsigned __int128 x = (unsigned __int128) r * list->size;
+	long long i = (long long) (x >> 64);
+	double u = (double) ((unsigned long long) x >> 11) * 0x1.0p-53;
+
+	return u < list->probability[i] ? i : list->alias[i];
+}
+
+/* Pick one of n things with the high bits of the product of r and n. */
+static inline int pick(unsigned long long r, int n)
+{
+	return (int) (((unsigned __int128) r * n) >> 64);
+}
+
+/*
+ * Write words of the sample text to str by walking the Markov chain from the
+ * start of a random line, starting a new line after a line ends, until the
+ * text is as long as a length picked between the minimum and maximum.  The
+ * text is cut off at the maximum.  Returns the length of the text.
+ */
+static inline int get_words(struct words_t *words, unsigned long long seed,
+		char *str)
+{
+	int target;
+	int length = 0;
+	int n;
+	int w = -1;
+
+	target = words->arg1 +
+			(int) ((words->arg2 - words->arg1 + 1) * splitmix64_real2(&seed));
+	while (length < target) {
+		if (w != -1)
+			w = words->next[words->first[w] + pick(splitmix64(&seed),
+					words->first[w + 1] - words->first[w])];
+		if (w == -1)
+			w = words->start[pick(splitmix64(&seed), words->starts)];
+
+		if (length > 0) {
+			/* Stop rather than end with a space at the maximum. */
+			if (length + 1 >= words->arg2)
+				break;
+			str[length++] = ' ';
+		}
+		n = words->length[w];
+		if (n > words->arg2 - length)
+			n = words->arg2 - length;
+		memcpy(str + length, words->list.arena + words->offset[w], n);
+		length += n;
+	}
+
+	return length;
+}
+
+/* A key for a column from its table's key, in one of the KEY_ domains. */
+static inline unsigned long long column_key(unsigned long long key,
+		unsigned long long domain, int col)
+{
+	unsigned long long state = key ^ domain;
+
+	return counter_random(splitmix64(&state), col);
+}
+
+/* The value of a unique column in a row, counting rows from 0. */
+static inline long long unique_value(struct unique_t *unique, long long row)
+{
+	return unique->arg1 + (long long) permute_counter(unique->key, row,
+			(unsigned long long) unique->arg2 - unique->arg1 + 1);
+}
+
+/*
+ * Limit a column to a number of distinct values by mapping its random number
+ * to one of that many others, so the values keep the column's distribution.
+ */
+static inline unsigned long long distinct_random(struct column_t *column,
+		unsigned long long r)
+{
+	return counter_random(column->distinct_key,
+			getrandU64(r, 0, column->distinct - 1));
+}
+
+/*
+ * Generate rows values of a column from the random numbers in r.  The column
+ * type is only looked at once per batch so each loop stays tight.
+ */
+int generate_values(struct table_definition_t *table, int col,
+		unsigned long long *r, int rows, long long first_row,
+		struct vector_t *vector)
+{
+	union arguments_t *arguments = &table->column[col].arguments;
+	long long *value = vector->value;
+	struct reference_t *ref;
+	struct column_t *column;
+	pcg64f_random_t rng;
+	long long row;
+	long long t;
+	int i;
+
+	switch (table->column[col].type) {
+	case TYPE_DATE:
+		/* Everything is in UTC so the day is just the seconds over 86400. */
+		for (i = 0; i < rows; i++) {
+			t = ((struct date_t *) arguments)->tloc1 + getrandU64(r[i], 0,
+					((struct date_t *) arguments)->diff);
+			value[i] = t / 86400 - (t % 86400 < 0);
+		}
+		break;
+	case TYPE_EXPONENTIAL:
+		for (i = 0; i < rows; i++)
+			value[i] = getExponentialRandU64(r[i],
+					((struct exponential_t *) arguments)->arg1,
+					((struct exponential_t *) arguments)->arg2,
+					((struct exponential_t *) arguments)->arg3);
+		break;
+	case TYPE_GAUSSIAN:
+		if (table->version == DATA_VERSION_1)
+			for (i = 0; i < rows; i++)
+				value[i] = getGaussianRandSeed(r[i],
+						((struct gaussian_t *) arguments)->arg1,
+						((struct gaussian_t *) arguments)->arg2,
+						((struct gaussian_t *) arguments)->arg3);
+		else
+			for (i = 0; i < rows; i++)
+				value[i] = getGaussianRandMix(r[i],
+						((struct gaussian_t *) arguments)->arg1,
+						((struct gaussian_t *) arguments)->arg2,
+						((struct gaussian_t *) arguments)->arg3);
+		break;
+	case TYPE_HOTSPOT:
+		for (i = 0; i < rows; i++)
+			value[i] = getHotspotRandU64(r[i],
+					((struct hotspot_t *) arguments)->arg1,
+					((struct hotspot_t *) arguments)->arg2,
+					((struct hotspot_t *) arguments)->arg3,
+					((struct hotspot_t *) arguments)->arg4);
+		break;
+	case TYPE_INTEGER:
+		for (i = 0; i < rows; i++)
+			value[i] = getrandU64(r[i], ((struct integer_t *) arguments)->arg1,
+					((struct integer_t *) arguments)->arg2);
+		break;
+	case TYPE_LIST:
+		for (i = 0; i < rows; i++)
+			value[i] = getrandU64(r[i], 0,
+					((struct list_t *) arguments)->size - 1);
+		break;
+	case TYPE_ZIPFIAN:
+		for (i = 0; i < rows; i++)
+			value[i] = getZipfianRandMix(r[i], (struct zipfian_t *) arguments);
+		break;
+	case TYPE_WEIGHTED_LIST:
+		for (i = 0; i < rows; i++)
+			value[i] = pick_weighted((struct list_t *) arguments, r[i]);
+		break;
+	case TYPE_POISSON:
+		for (i = 0; i < rows; i++)
+			value[i] = getPoissonRandU64(r[i],
+					((struct poisson_t *) arguments)->arg1);
+		break;
+	case TYPE_REFERENCE:
+		ref = (struct reference_t *) arguments;
+		column = &ref->table->column[ref->column];
+		if (column->type == TYPE_SEQUENCE) {
+			for (i = 0; i < rows; i++)
+				value[i] = getrandU64(r[i], 0, ref->table->rows - 1) +
+						((struct sequence_t *) &column->arguments)->arg1;
+			break;
+		}
+		if (column->type == TYPE_UNIQUE) {
+			for (i = 0; i < rows; i++)
+				value[i] = unique_value((struct unique_t *) &column->arguments,
+						getrandU64(r[i], 0, ref->table->rows - 1));
+			break;
+		}
+
+		{
+			/* The random numbers the referenced rows used for the column. */
+			unsigned long long ref_r[BATCH_ROWS];
+
+			for (i = 0; i < rows; i++) {
+				row = getrandU64(r[i], 0, ref->table->rows - 1);
+				if (table->version >= DATA_VERSION_3)
+					ref_r[i] = counter_random(ref->table->key,
+							row * MAX_COLS + ref->column);
+				else {
+					rng = ref->rng;
+					pcg64f_advance_r(&rng, row * ref->multiplier + ref->draw);
+					ref_r[i] = pcg64f_random_r(&rng);
+				}
+				if (column->distinct != 0)
+					ref_r[i] = distinct_random(column, ref_r[i]);
+			}
+			return generate_values(ref->table, ref->column, ref_r, rows, 0,
+					vector);
+		}
+	case TYPE_SEQUENCE:
+		for (i = 0; i < rows; i++)
+			value[i] = first_row + i +
+					((struct sequence_t *) arguments)->arg1;
+		break;
+	case TYPE_TIMESTAMP:
+	case TYPE_TIMESTAMPTZ:
+		for (i = 0; i < rows; i++)
+			value[i] = getrandU64(r[i],
+					((struct timestamp_t *) arguments)->arg1,
+					((struct timestamp_t *) arguments)->arg2 - 1);
+		break;
+	case TYPE_UNIQUE:
+		for (i = 0; i < rows; i++)
+			value[i] = unique_value((struct unique_t *) arguments,
+					first_row + i);
+		break;
+	case TYPE_TEXT:
+		vector->offset[0] = 0;
+		for (i = 0; i < rows; i++) {
+			char *p = vector->text + vector->offset[i];
+
+			if (table->version == DATA_VERSION_1)
+				get_alpha_seed(r[i], p, ((struct text_t *) arguments)->arg1,
+						((struct text_t *) arguments)->arg2);
+			else
+				get_alpha_mix(r[i], p, ((struct text_t *) arguments)->arg1,
+						((struct text_t *) arguments)->arg2);
+			vector->offset[i + 1] = vector->offset[i] + strlen(p);
+		}
+		break;
+	case TYPE_WORDS:
+		vector->offset[0] = 0;
+		for (i = 0; i < rows; i++)
+			vector->offset[i + 1] = vector->offset[i] +
+					get_words((struct words_t *) arguments, r[i],
+							vector->text + vector->offset[i]);
+		break;
+	default:
+		fprintf(stderr, "ERROR: unhandled column definition: %c\n",
+				table->column[col].type);
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Evaluate an expression for a batch, one operation at a time over all the
+ * rows, using the values of the columns already generated.
+ */
+int generate_expression(struct table_definition_t *table, int col,
+		struct batch_t *batch)
+{
+	struct expression_t *e =
+			(struct expression_t *) &table->column[col].arguments;
+	struct operation_t *op;
+	long long stack[MAX_EXPRESSION_DEPTH][BATCH_ROWS];
+	long long *x, *y;
+	int sp = 0;
+	int i, j;
+
+	for (j = 0; j < e->ops; j++) {
+		op = &e->op[j];
+		x = stack[sp - 2 < 0 ? 0 : sp - 2];
+		y = stack[sp - 1 < 0 ? 0 : sp - 1];
+		switch (op->code) {
+		case OP_CONSTANT:
+			for (i = 0; i < batch->rows; i++)
+				stack[sp][i] = op->arg1;
+			++sp;
+			break;
+		case OP_COLUMN:
+			memcpy(stack[sp], batch->vector[op->arg1].value,
+					sizeof(long long) * batch->rows);
+			++sp;
+			/* Anything with a NULL is NULL. */
+			if (batch->vector[op->arg1].null != NULL)
+				for (i = 0; i < batch->rows; i++)
+					batch->vector[col].null[i] |=
+							batch->vector[op->arg1].null[i];
+			break;
+		case OP_RANDOM:
+			for (i = 0; i < batch->rows; i++)
+				stack[sp][i] = getrandU64(batch->r[i], op->arg1, op->arg2);
+			++sp;
+			break;
+		/* Overflow wraps around, as in two's complement. */
+		case OP_NEGATE:
+			for (i = 0; i < batch->rows; i++)
+				y[i] = (long long) (0 - (unsigned long long) y[i]);
+			break;
+		case OP_ADD:
+			for (i = 0; i < batch->rows; i++)
+				x[i] = (long long) ((unsigned long long) x[i] +
+						(unsigned long long) y[i]);
+			--sp;
+			break;
+		case OP_SUBTRACT:
+			for (i = 0; i < batch->rows; i++)
+				x[i] = (long long) ((unsigned long long) x[i] -
+						(unsigned long long) y[i]);
+			--sp;
+			break;
+		case OP_MULTIPLY:
+			for (i = 0; i < batch->rows; i++)
+				x[i] = (long long) ((unsigned long long) x[i] *
+						(unsigned long long) y[i]);
+			--sp;
+			break;
+		/*
+		 * Dividing by zero gives zero rather than stopping, and dividing by
+		 * -1 negates so the smallest integer doesn't trap.
+		 */
+		case OP_DIVIDE:
+			for (i = 0; i < batch->rows; i++)
+				x[i] = y[i] == 0 ? 0 : y[i] == -1 ?
+						(long long) (0 - (unsigned long long) x[i]) :
+						x[i] / y[i];
+			--sp;
+			break;
+		case OP_MODULO:
+			for (i = 0; i < batch->rows; i++)
+				x[i] = y[i] == 0 || y[i] == -1 ? 0 : x[i] % y[i];
+			--sp;
+			break;
+		}
+	}
+	memcpy(batch->vector[col].value, stack[0],
+			sizeof(long long) * batch->rows);
+
+	return 0;
+}
+
+/* Generate one column of a batch from the random numbers in batch->r. */
+int generate_column(struct table_definition_t *table, int col,
+		struct batch_t *batch)
+{
+	if (table->column[col].type == TYPE_EXPRESSION)
+		return generate_expression(table, col, batch);
+	return generate_values(table, col, batch->r, batch->rows,
+			batch->first_row, &batch->vector[col]);
+}
+
+/* Generate rows first_row up to rows more a column at a time. */
+int generate_batch(pcg64f_random_t *rng, struct table_definition_t *table,
+		struct batch_t *batch, long long first_row, int rows)
+{
+	struct column_t *column;
+	struct vector_t *vector;
+	int i, k;
+	int col;
+
+	batch->first_row = first_row;
+	batch->rows = rows;
+
+	if (table->version < DATA_VERSION_3)
+		for (i = 0; i < rows * batch->multiplier; i++)
+			batch->draws[i] = pcg64f_random_r(rng);
+
+	k = 0;
+	for (col = 0; col < table->columns; col++) {
+		column = &table->column[col];
+		vector = &batch->vector[col];
+
+		/* Every column type other than these uses 1 random number. */
+		if (column->type != TYPE_SEQUENCE && column->type != TYPE_UNIQUE) {
+			if (table->version >= DATA_VERSION_3)
+				for (i = 0; i < rows; i++)
+					batch->r[i] = counter_random(table->key,
+							(first_row + i) * MAX_COLS + col);
+			else
+				for (i = 0; i < rows; i++)
+					batch->r[i] = batch->draws[i * batch->multiplier + k];
+			++k;
+			if (column->distinct != 0)
+				for (i = 0; i < rows; i++)
+					batch->r[i] = distinct_random(column, batch->r[i]);
+		}
+
+		if (vector->null != NULL)
+			memset(vector->null, 0, rows);
+		if (generate_column(table, col, batch) != 0)
+			return 1;
+
+		/* NULLs depend only on the row, not on any random number. */
+		if (column->nulls != 0)
+			for (i = 0; i < rows; i++)
+				if (counter_random(column->null_key, first_row + i) <
+						column->nulls)
+					vector->null[i] = 1;
+	}
+
+	return 0;
+}
+
+/* Write to the columnar output, keeping track of where the file is at. */
+int columnar_write(struct columnar_t *c, const char *data, size_t len)
+{
+	c->offset += len;
+	if (output_append(c->out, data, len) != 0)
+		return 1;
+	if (c->out->len >= c->out->flush_size)
+		return output_flush(c->out);
+	return 0;
+}
+
+int row_group_init(struct row_group_t *rg, struct table_definition_t *table)
+{
+	int col;
+
+	rg->rows = 0;
+	rg->chunk = (struct column_chunk_t *) calloc(table->columns,
+			sizeof(struct column_chunk_t));
+	if (rg->chunk == NULL) {
+		fprintf(stderr, "ERROR: cannot allocate memory for column chunks\n");
+		return 1;
+	}
+	for (col = 0; col < table->columns; col++) {
+		rg->chunk[col].encoding = (table->column[col].type == TYPE_LIST ||
+				table->column[col].type == TYPE_WEIGHTED_LIST) &&
+				((struct list_t *) &table->column[col].arguments)->size <=
+						MAX_DICTIONARY_SIZE ?
+				ENCODING_DICTIONARY : ENCODING_PLAIN;
+		if (output_init(&rg->chunk[col].data, FORMAT_COLUMNAR, -1,
+				ROW_GROUP_ROWS * 8) != 0)
+			return 1;
+		if (table->column[col].nullable) {
+			rg->chunk[col].nulls =
+					(unsigned char *) calloc(ROW_GROUP_ROWS / 8, 1);
+			if (rg->chunk[col].nulls == NULL) {
+				fprintf(stderr, "ERROR: cannot allocate memory for NULLs\n");
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+void row_group_free(struct row_group_t *rg, struct table_definition_t *table)
+{
+	int col;
+
+	if (rg->chunk != NULL)
+		for (col = 0; col < table->columns; col++) {
+			free(rg->chunk[col].data.data);
+			free(rg->chunk[col].min_text);
+			free(rg->chunk[col].max_text);
+			free(rg->chunk[col].nulls);
+		}
+	free(rg->chunk);
+}
+
+int columnar_init(struct columnar_t *c, struct output_t *out,
+		struct table_definition_t *table)
+{
+	char buf[4];
+	int col;
+
+	memset(c, 0, sizeof(struct columnar_t));
+	c->table = table;
+	c->out = out;
+
+	/* The footer starts with the schema: each column's type and kind. */
+	if (output_init(&c->footer, FORMAT_COLUMNAR, -1, MAX_BUFFER_LEN) != 0)
+		return 1;
+	if (output_reserve(&c->footer, 4) == NULL)
+		return 1;
+	put_int32(c->footer.data, table->columns);
+	c->footer.len = 4;
+	for (col = 0; col < table->columns; col++) {
+		buf[0] = table->column[col].type;
+		switch (value_type(table, col)) {
+		case TYPE_DATE:
+			buf[1] = VALUE_DATE;
+			break;
+		case TYPE_TIMESTAMP:
+			buf[1] = VALUE_TIMESTAMP;
+			break;
+		case TYPE_TIMESTAMPTZ:
+			buf[1] = VALUE_TIMESTAMPTZ;
+			break;
+		case TYPE_LIST:
+		case TYPE_TEXT:
+		case TYPE_WEIGHTED_LIST:
+		case TYPE_WORDS:
+			buf[1] = VALUE_TEXT;
+			break;
+		default:
+			buf[1] = VALUE_INTEGER;
+			break;
+		}
+		/* Numerics are followed by their precision and scale. */
+		if (table->column[col].precision != 0) {
+			buf[1] = VALUE_NUMERIC;
+			buf[2] = (char) table->column[col].precision;
+			buf[3] = (char) table->column[col].scale;
+		}
+		if (output_append(&c->footer, buf,
+				buf[1] == VALUE_NUMERIC ? 4 : 2) != 0)
+			return 1;
+	}
+
+	return columnar_write(c, COLUMNAR_MAGIC, COLUMNAR_MAGIC_LEN);
+}
+
+/* Remember a copy of text as the new minimum or maximum of a chunk. */
+int chunk_stat_text(char **stat, size_t *stat_len, const char *text,
+		size_t len)
+{
+	char *p = (char *) realloc(*stat, len + 1);
+
+	if (p == NULL) {
+		fprintf(stderr, "ERROR: cannot allocate memory for statistics\n");
+		return 1;
+	}
+	memcpy(p, text, len);
+	*stat = p;
+	*stat_len = len;
+	return 0;
+}
+
+static inline int compare_text(const char *a, size_t alen, const char *b,
+		size_t blen)
+{
+	int rc = memcmp(a, b, alen < blen ? alen : blen);
+
+	if (rc != 0)
+		return rc;
+	return alen < blen ? -1 : (alen > blen);
+}
+
+static inline int compare_list(struct list_t *list, long long a, long long b)
+{
+	return compare_text(list->arena + list->offset[a], list->length[a],
+			list->arena + list->offset[b], list->length[b]);
+}
+
+/*
+ * Append a text value to a plain chunk, keeping track of its range unless the
+ * value is NULL.
+ */
+int chunk_add_text(struct column_chunk_t *chunk, const char *text, size_t len,
+		int null)
+{
+	char *p = output_reserve(&chunk->data, len + 4);
+
+	if (p == NULL)
+		return 1;
+	put_int32(p, (int) len);
+	memcpy(p + 4, text, len);
+	chunk->data.len += len + 4;
+
+	if (null)
+		return 0;
+	if (!chunk->has_stats) {
+		if (chunk_stat_text(&chunk->min_text, &chunk->min_len, text,
+				len) != 0 ||
+				chunk_stat_text(&chunk->max_text, &chunk->max_len, text,
+						len) != 0)
+			return 1;
+		chunk->has_stats = 1;
+	} else if (compare_text(text, len, chunk->min_text, chunk->min_len) < 0) {
+		if (chunk_stat_text(&chunk->min_text, &chunk->min_len, text,
+				len) != 0)
+			return 1;
+	} else if (compare_text(text, len, chunk->max_text, chunk->max_len) > 0) {
+		if (chunk_stat_text(&chunk->max_text, &chunk->max_len, text,
+				len) != 0)
+			return 1;
+	}
+	return 0;
+}
+
+static inline int is_null(struct vector_t *vector, int i)
+{
+	return vector->null != NULL && vector->null[i];
+}
+
+/* Append a batch to the column chunks of a row group. */
+int row_group_add_batch(struct row_group_t *rg,
+		struct table_definition_t *table, struct batch_t *batch)
+{
+	struct column_chunk_t *chunk;
+	struct vector_t *vector;
+	struct list_t *list;
+	char *p;
+	int col;
+	int i;
+
+	for (col = 0; col < table->columns; col++) {
+		chunk = &rg->chunk[col];
+		vector = &batch->vector[col];
+
+		if (chunk->nulls != NULL)
+			for (i = 0; i < batch->rows; i++)
+				if (is_null(vector, i))
+					chunk->nulls[(rg->rows + i) / 8] |=
+							1 << ((rg->rows + i) % 8);
+
+		switch (vector->kind) {
+		case VALUE_INTEGER:
+		case VALUE_DATE:
+		case VALUE_TIMESTAMP:
+		case VALUE_TIMESTAMPTZ:
+		case VALUE_NUMERIC:
+			p = output_reserve(&chunk->data, 8 * batch->rows);
+			if (p == NULL)
+				return 1;
+			for (i = 0; i < batch->rows; i++) {
+				put_int64(p + i * 8, vector->value[i]);
+				if (is_null(vector, i))
+					continue;
+				if (!chunk->has_stats) {
+					chunk->min = chunk->max = vector->value[i];
+					chunk->has_stats = 1;
+				} else if (vector->value[i] < chunk->min)
+					chunk->min = vector->value[i];
+				else if (vector->value[i] > chunk->max)
+					chunk->max = vector->value[i];
+			}
+			chunk->data.len += 8 * batch->rows;
+			break;
+		case VALUE_LIST:
+			list = (struct list_t *) &table->column[col].arguments;
+			if (chunk->encoding == ENCODING_PLAIN) {
+				for (i = 0; i < batch->rows; i++)
+					if (chunk_add_text(chunk,
+							list->arena + list->offset[vector->value[i]],
+							list->length[vector->value[i]],
+							is_null(vector, i)) != 0)
+						return 1;
+				break;
+			}
+
+			/* The list itself is the dictionary, only indexes are stored. */
+			p = output_reserve(&chunk->data, 4 * batch->rows);
+			if (p == NULL)
+				return 1;
+			for (i = 0; i < batch->rows; i++) {
+				put_int32(p + i * 4, (int) vector->value[i]);
+				if (is_null(vector, i))
+					continue;
+				if (!chunk->has_stats) {
+					chunk->min = chunk->max = vector->value[i];
+					chunk->has_stats = 1;
+				} else if (compare_list(list, vector->value[i],
+						chunk->min) < 0)
+					chunk->min = vector->value[i];
+				else if (compare_list(list, vector->value[i],
+						chunk->max) > 0)
+					chunk->max = vector->value[i];
+			}
+			chunk->data.len += 4 * batch->rows;
+			break;
+		case VALUE_TEXT:
+			for (i = 0; i < batch->rows; i++)
+				if (chunk_add_text(chunk, vector->text + vector->offset[i],
+						vector->offset[i + 1] - vector->offset[i],
+						is_null(vector, i)) != 0)
+					return 1;
+			break;
+		}
+	}
+
+	rg->rows += batch->rows;
+
+	return 0;
+}
+
+/* Append a length prefixed string to a buffer. */
+int output_string(struct output_t *out, const char *str, size_t len)
+{
+	char *p = output_reserve(out, len + 4);
+
+	if (p == NULL)
+		return 1;
+	put_int32(p, (int) len);
+	memcpy(p + 4, str, len);
+	out->len += len + 4;
+	return 0;
+}
+
+/*
+ * Write out the column chunks of a row group, and describe them in the footer:
+ * the row count, then each chunk's offset, length, encoding and minimum and
+ * maximum values.  The row group is emptied for reuse.
+ */
+int columnar_write_row_group(struct columnar_t *c, struct row_group_t *rg)
+{
+	struct table_definition_t *table = c->table;
+	struct column_chunk_t *chunk;
+	struct list_t *list;
+	char buf[17];
+	long long offset;
+	int encoding;
+	int col;
+	int i;
+
+	if (rg->rows == 0)
+		return 0;
+
+	if (output_reserve(&c->footer, 8) == NULL)
+		return 1;
+	put_int64(c->footer.data + c->footer.len, rg->rows);
+	c->footer.len += 8;
+
+	for (col = 0; col < table->columns; col++) {
+		chunk = &rg->chunk[col];
+		offset = c->offset;
+
+		/* Each chunk starts with its encoding, any NULLs then dictionary. */
+		encoding = chunk->encoding |
+				(chunk->nulls != NULL ? ENCODING_NULLS : 0);
+		buf[0] = (char) encoding;
+		if (columnar_write(c, buf, 1) != 0)
+			return 1;
+		if (chunk->nulls != NULL) {
+			if (columnar_write(c, (char *) chunk->nulls,
+					(rg->rows + 7) / 8) != 0)
+				return 1;
+			memset(chunk->nulls, 0, ROW_GROUP_ROWS / 8);
+		}
+		if (chunk->encoding == ENCODING_DICTIONARY) {
+			list = (struct list_t *) &table->column[col].arguments;
+			put_int32(buf, list->size);
+			if (columnar_write(c, buf, 4) != 0)
+				return 1;
+			for (i = 0; i < list->size; i++) {
+				put_int32(buf, list->length[i]);
+				if (columnar_write(c, buf, 4) != 0 ||
+						columnar_write(c, list->arena + list->offset[i],
+								list->length[i]) != 0)
+					return 1;
+			}
+		}
+		if (columnar_write(c, chunk->data.data, chunk->data.len) != 0)
+			return 1;
+
+		if (output_reserve(&c->footer, 17) == NULL)
+			return 1;
+		put_int64(c->footer.data + c->footer.len, offset);
+		put_int64(c->footer.data + c->footer.len + 8, c->offset - offset);
+		c->footer.data[c->footer.len + 16] = (char) encoding;
+		c->footer.len += 17;
+
+		/* A chunk of only NULLs has no range. */
+		if (!chunk->has_stats) {
+			chunk->min = chunk->max = 0;
+			chunk->min_len = chunk->max_len = 0;
+		}
+
+		switch (chunk->encoding == ENCODING_DICTIONARY ? VALUE_LIST :
+				table->column[col].type == TYPE_TEXT ||
+				table->column[col].type == TYPE_LIST ||
+				table->column[col].type == TYPE_WEIGHTED_LIST ||
+				table->column[col].type == TYPE_WORDS ? VALUE_TEXT :
+				VALUE_INTEGER) {
+		case VALUE_LIST:
+			list = (struct list_t *) &table->column[col].arguments;
+			if (output_string(&c->footer,
+					list->arena + list->offset[chunk->min],
+					list->length[chunk->min]) != 0 ||
+					output_string(&c->footer,
+							list->arena + list->offset[chunk->max],
+							list->length[chunk->max]) != 0)
+				return 1;
+			break;
+		case VALUE_TEXT:
+			if (output_string(&c->footer, chunk->min_text,
+					chunk->min_len) != 0 ||
+					output_string(&c->footer, chunk->max_text,
+							chunk->max_len) != 0)
+				return 1;
+			break;
+		default:
+			if (output_reserve(&c->footer, 16) == NULL)
+				return 1;
+			put_int64(c->footer.data + c->footer.len, chunk->min);
+			put_int64(c->footer.data + c->footer.len + 8, chunk->max);
+			c->footer.len += 16;
+			break;
+		}
+
+		chunk->data.len = 0;
+		chunk->has_stats = 0;
+	}
+
+	++c->row_groups;
+	rg->rows = 0;
+
+	return 0;
+}
+
+/* Finish with the footer, its length and the magic again. */
+int columnar_finish(struct columnar_t *c)
+{
+	char buf[4];
+
+	if (output_reserve(&c->footer, 4) == NULL)
+		return 1;
+	put_int32(c->footer.data + c->footer.len, c->row_groups);
+	c->footer.len += 4;
+
+	if (columnar_write(c, c->footer.data, c->footer.len) != 0)
+		return 1;
+	put_int32(buf, (int) c->footer.len);
+	if (columnar_write(c, buf, 4) != 0)
+		return 1;
+	return columnar_write(c, COLUMNAR_MAGIC, COLUMNAR_MAGIC_LEN);
+}
+
+void columnar_free(struct columnar_t *c)
+{
+	free(c->footer.data);
+}
+
+/* Add the rows of a batch to the output, one row at a time. */
+int output_batch(struct output_t *out, struct table_definition_t *table,
+		struct batch_t *batch, char delimiter)
+{
+	struct vector_t *vector;
+	struct list_t *list;
+	const char *p;
+	int end = table->columns - 1;
+	int i;
+	int col;
+
+	for (i = 0; i < batch->rows; i++) {
+		if (output_row_start(out, table->columns) != 0)
+			return 1;
+		for (col = 0; col < table->columns; col++) {
+			vector = &batch->vector[col];
+			switch (is_null(vector, i) ? VALUE_NULL : vector->kind) {
+			case VALUE_NULL:
+				if (output_null(out) != 0)
+					return 1;
+				break;
+			case VALUE_INTEGER:
+				if (output_integer(out, vector->value[i]) != 0)
+					return 1;
+				break;
+			case VALUE_DATE:
+				if (output_date(out, (int) vector->value[i]) != 0)
+					return 1;
+				break;
+			case VALUE_TIMESTAMP:
+			case VALUE_TIMESTAMPTZ:
+				if (output_timestamp(out, vector->value[i],
+						vector->kind == VALUE_TIMESTAMPTZ) != 0)
+					return 1;
+				break;
+			case VALUE_NUMERIC:
+				if (output_numeric(out, vector->value[i],
+						vector->scale) != 0)
+					return 1;
+				break;
+			case VALUE_TEXT:
+				if (output_text(out, vector->text + vector->offset[i],
+						vector->offset[i + 1] - vector->offset[i]) != 0)
+					return 1;
+				break;
+			case VALUE_LIST:
+				list = (struct list_t *) &table->column[col].arguments;
+				p = list->arena + list->offset[vector->value[i]];
+				if (output_text(out, p, list->length[vector->value[i]]) != 0)
+					return 1;
+				break;
+			}
+			if (col < end && out->format == FORMAT_TEXT &&
+					output_append(out, &delimiter, 1) != 0)
+				return 1;
+		}
+		if (output_row_end(out) != 0)
+			return 1;
+	}
+
+	return 0;
+}
+
+/* Write a CSV line of what a thread, or all of them, did by now. */
+void progress_csv(struct progress_t *progress, double elapsed,
+		const char *thread, struct thread_stats_t *stats,
+		struct thread_stats_t *reported, double seconds)
+{
+	fprintf(progress->stats, "%s,%.3f,%s,%lld,%lld,%.0f,%.3f,%.3f,%.3f,"
+			"%.3f\n", progress->table, elapsed, thread, stats->rows,
+			stats->bytes, (stats->rows - reported->rows) / seconds,
+			(stats->bytes - reported->bytes) / seconds / 1e6,
+			stats->generate_ns / 1e9, stats->wait_ns / 1e9,
+			stats->write_ns / 1e9);
+}
+
+/*
+ * Report progress: a line on stderr with the rows done and the rates since
+ * the last report, and a CSV line per thread and for all threads together.
+ * The final report gives the rates over the whole run on its line.
+ */
+void progress_report(struct progress_t *progress, int final)
+{
+	struct thread_stats_t all, last;
+	struct timespec now;
+	double elapsed, seconds;
+	long long busy_ns;
+	char thread[16];
+	int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = (double) (now.tv_sec - progress->start.tv_sec) +
+			(now.tv_nsec - progress->start.tv_nsec) / 1e9;
+	seconds = elapsed - progress->last > 0 ? elapsed - progress->last : 1e-9;
+
+	memset(&all, 0, sizeof(struct thread_stats_t));
+	memset(&last, 0, sizeof(struct thread_stats_t));
+	pthread_mutex_lock(&progress->lock);
+	for (i = 0; i < progress->threads; i++) {
+		all.rows += progress->thread[i].rows;
+		all.bytes += progress->thread[i].bytes;
+		all.generate_ns += progress->thread[i].generate_ns;
+		all.wait_ns += progress->thread[i].wait_ns;
+		all.write_ns += progress->thread[i].write_ns;
+		last.rows += progress->reported[i].rows;
+		last.bytes += progress->reported[i].bytes;
+		if (progress->stats != NULL) {
+			sprintf(thread, "%d", i);
+			progress_csv(progress, elapsed, thread,
+					&progress->thread[i], &progress->reported[i],
+					seconds);
+		}
+		progress->reported[i] = progress->thread[i];
+	}
+	pthread_mutex_unlock(&progress->lock);
+
+	if (progress->stats != NULL) {
+		progress_csv(progress, elapsed, "all", &all, &last, seconds);
+		fflush(progress->stats);
+	}
+	progress->last = elapsed;
+	if (!progress->print)
+		return;
+
+	if (final) {
+		seconds = elapsed > 0 ? elapsed : 1e-9;
+		memset(&last, 0, sizeof(struct thread_stats_t));
+	}
+	busy_ns = all.generate_ns + all.wait_ns + all.write_ns;
+	if (busy_ns == 0)
+		busy_ns = 1;
+	fprintf(stderr, "%s%s: %lld of %lld rows (%.0f%%) in %.0fs, "
+			"%.0f rows/s, %.1f MB/s, time generating %.0f%%, "
+			"waiting %.0f%%, writing %.0f%%%s",
+			progress->tty ? "\r" : "", progress->table, all.rows,
+			progress->rows, progress->rows > 0 ?
+			100.0 * all.rows / progress->rows : 100.0, elapsed,
+			(all.rows - last.rows) / seconds,
+			(all.bytes - last.bytes) / seconds / 1e6,
+			100.0 * all.generate_ns / busy_ns,
+			100.0 * all.wait_ns / busy_ns,
+			100.0 * all.write_ns / busy_ns,
+			progress->tty && !final ? "" : "\n");
+}
+
+void *progress_thread(void *data)
+{
+	struct progress_t *progress = (struct progress_t *) data;
+	struct timespec deadline;
+
+	pthread_mutex_lock(&progress->lock);
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	while (!progress->done) {
+		deadline.tv_sec += progress->interval;
+		while (!progress->done && pthread_cond_timedwait(&progress->cond,
+				&progress->lock, &deadline) != ETIMEDOUT)
+			;
+		if (progress->done)
+			break;
+		pthread_mutex_unlock(&progress->lock);
+		progress_report(progress, 0);
+		pthread_mutex_lock(&progress->lock);
+	}
+	pthread_mutex_unlock(&progress->lock);
+
+	return NULL;
+}
+
+/* Start reporting the progress of threads generating rows. */
+int progress_start(struct progress_t *progress, int threads)
+{
+	progress->threads = threads;
+	progress->thread = (struct thread_stats_t *) calloc(threads,
+			sizeof(struct thread_stats_t));
+	progress->reported = (struct thread_stats_t *) calloc(threads,
+			sizeof(struct thread_stats_t));
+	if (progress->thread == NULL || progress->reported == NULL) {
+		fprintf(stderr, "ERROR: cannot allocate memory for progress\n");
+		return 1;
+	}
+	progress->done = 0;
+	progress->last = 0;
+	progress->tty = isatty(STDERR_FILENO);
+	clock_gettime(CLOCK_MONOTONIC, &progress->start);
+	pthread_mutex_init(&progress->lock, NULL);
+	pthread_cond_init(&progress->cond, NULL);
+	if (pthread_create(&progress->tid, NULL, progress_thread,
+			progress) != 0) {
+		fprintf(stderr, "ERROR: cannot create progress thread\n");
+		pthread_cond_destroy(&progress->cond);
+		pthread_mutex_destroy(&progress->lock);
+		free(progress->thread);
+		free(progress->reported);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Stop reporting progress, with a final report. */
+void progress_stop(struct progress_t *progress)
+{
+	pthread_mutex_lock(&progress->lock);
+	progress->done = 1;
+	pthread_cond_signal(&progress->cond);
+	pthread_mutex_unlock(&progress->lock);
+	pthread_join(progress->tid, NULL);
+
+	progress_report(progress, 1);
+
+	pthread_cond_destroy(&progress->cond);
+	pthread_mutex_destroy(&progress->lock);
+	free(progress->thread);
+	free(progress->reported);
+}
+
+/*
+ * Generate rows first_row up to last_row a batch at a time.  Columnar data is
+ * added to the row group, everything else to out which is flushed if it has
+ * somewhere to go.
+ */
+int generate_rows(pcg64f_random_t *rng, struct table_definition_t *table,
+		struct batch_t *batch, struct output_t *out, struct row_group_t *rg,
+		char delimiter, long long first_row, long long last_row)
+{
+	struct timespec t;
+	long long row;
+	int rows;
+
+	if (out->progress != NULL)
+		clock_gettime(CLOCK_MONOTONIC, &t);
+	for (row = first_row; row < last_row; row += rows) {
+		rows = last_row - row < BATCH_ROWS ? last_row - row : BATCH_ROWS;
+		if (generate_batch(rng, table, batch, row, rows) != 0)
+			return 1;
+
+		if (out->format == FORMAT_COLUMNAR) {
+			if (row_group_add_batch(rg, table, batch) != 0)
+				return 1;
+		} else if (output_batch(out, table, batch, delimiter) != 0)
+			return 1;
+		if (out->progress != NULL)
+			progress_add(out->progress, out->thread, rows, 0,
+					lap(&t), 0, 0);
+		if (out->format == FORMAT_COLUMNAR)
+			continue;
+
+		if ((out->fd != -1 || out->conn != NULL) &&
+				out->len >= out->flush_size) {
+			if (output_flush(out) != 0)
+				return 1;
+			if (checkpoint_write(out->checkpoint, row + rows, 0) != 0)
+				return 1;
+			/* Flushing counted its own time. */
+			if (out->progress != NULL)
+				clock_gettime(CLOCK_MONOTONIC, &t);
+		}
+	}
+
+	return 0;
+}
+
+void *generate_worker(void *data)
+{
+	struct worker_t *worker = (struct worker_t *) data;
+	struct parallel_t *parallel = worker->parallel;
+	struct table_definition_t *table = parallel->table;
+
+	pcg64f_random_t rng;
+	struct batch_t batch;
+	struct output_t out;
+	struct row_group_t rg;
+	struct timespec t;
+	long long block;
+	long long first_row, last_row;
+	long long generate_ns, wait_ns;
+	long long bytes;
+	size_t offset = 0;
+	int rc;
+
+	/*
+	 * Each thread fills its own buffer or row group, and writes it out when
+	 * it's its turn.  Into a mapped file only the offset is taken in turn.
+	 * When loading a database each thread has its own COPY instead and the
+	 * order does not matter.
+	 */
+	memset(&rg, 0, sizeof(struct row_group_t));
+	memset(&out, 0, sizeof(struct output_t));
+	rc = batch_init(&batch, table, parallel->multiplier);
+	if (rc == 0)
+		rc = output_init(&out, parallel->format, -1, parallel->flush_size);
+	out.compress = parallel->compress;
+	out.level = parallel->level;
+	out.uring = parallel->uring;
+	out.progress = parallel->progress;
+	out.thread = worker->id;
+	if (rc == 0 && parallel->format == FORMAT_COLUMNAR)
+		rc = row_group_init(&rg, table);
+	if (rc == 0 && parallel->database != NULL)
+		rc = copy_start(&out, parallel->database);
+
+	for (block = worker->id; rc == 0; block += parallel->threads) {
+		first_row = parallel->first_row + block * parallel->block_rows;
+		if (first_row >= parallel->last_row)
+			break;
+		last_row = first_row + parallel->block_rows;
+		if (last_row > parallel->last_row)
+			last_row = parallel->last_row;
+
+		/* Position a private prng at the first row of this block. */
+		rng = parallel->rng;
+		if (table->version < DATA_VERSION_3)
+			pcg64f_advance_r(&rng, first_row * parallel->multiplier);
+
+		if (out.conn != NULL) {
+			rc = generate_rows(&rng, table, &batch, &out, &rg,
+					parallel->delimiter, first_row, last_row);
+			/* Stop early if another thread failed. */
+			pthread_mutex_lock(&parallel->lock);
+			if (rc == 0)
+				rc = parallel->error;
+			pthread_mutex_unlock(&parallel->lock);
+			continue;
+		}
+
+		out.len = 0;
+		rc = generate_rows(&rng, table, &batch, &out, &rg,
+				parallel->delimiter, first_row, last_row);
+		/* Compress in parallel, only the writing is in turn. */
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		if (rc == 0 && out.compress != COMPRESS_NONE &&
+				parallel->format != FORMAT_COLUMNAR)
+			rc = output_compress(&out);
+		generate_ns = lap(&t);
+
+		/* Wait until it is this block's turn to be written out. */
+		pthread_mutex_lock(&parallel->lock);
+		while (parallel->next_block != block && parallel->error == 0)
+			pthread_cond_wait(&parallel->cond, &parallel->lock);
+		wait_ns = lap(&t);
+		bytes = out.compress == COMPRESS_NONE ? out.len : out.zlen;
+		if (parallel->error == 0) {
+			if (rc != 0)
+				parallel->error = rc;
+			else if (parallel->map != NULL) {
+				offset = parallel->map_len;
+				if (offset + out.len > parallel->map_size) {
+					fprintf(stderr,
+							"ERROR: data exceeds the mapped file size\n");
+					parallel->error = 1;
+				} else
+					parallel->map_len += out.len;
+			} else if (parallel->format == FORMAT_COLUMNAR) {
+				bytes = parallel->columnar->offset;
+				if (columnar_write_row_group(parallel->columnar, &rg) != 0)
+					parallel->error = 1;
+				bytes = parallel->columnar->offset - bytes;
+			} else if (output_write(&out, parallel->fd) != 0 ||
+					checkpoint_write(parallel->checkpoint, last_row,
+							0) != 0)
+				parallel->error = 1;
+		}
+		++parallel->next_block;
+		pthread_cond_broadcast(&parallel->cond);
+		rc = parallel->error;
+		pthread_mutex_unlock(&parallel->lock);
+
+		if (rc == 0 && parallel->map != NULL)
+			memcpy(parallel->map + offset, out.data, out.len);
+		progress_add(parallel->progress, worker->id, 0, bytes,
+				generate_ns, wait_ns, lap(&t));
+	}
+
+	if (out.conn != NULL)
+		rc = copy_end(&out, rc);
+	if (rc != 0) {
+		pthread_mutex_lock(&parallel->lock);
+		if (parallel->error == 0)
+			parallel->error = rc;
+		pthread_cond_broadcast(&parallel->cond);
+		pthread_mutex_unlock(&parallel->lock);
+	}
+
+	row_group_free(&rg, table);
+	output_free(&out);
+	batch_free(&batch, table);
+
+	return NULL;
+}
+
+int generate_parallel(pcg64f_random_t *rng, struct output_t *out,
+		struct database_t *database, struct columnar_t *columnar,
+		struct table_definition_t *table, char delimiter, int multiplier,
+		long long first_row, long long last_row, int threads,
+		struct progress_t *progress)
+{
+	struct parallel_t parallel;
+	struct worker_t *worker;
+	int i;
+
+	worker = (struct worker_t *) malloc(sizeof(struct worker_t) * threads);
+	if (worker == NULL) {
+		fprintf(stderr, "ERROR: cannot allocate memory for %d threads\n",
+				threads);
+		return 1;
+	}
+
+	memset(&parallel, 0, sizeof(struct parallel_t));
+	pthread_mutex_init(&parallel.lock, NULL);
+	pthread_cond_init(&parallel.cond, NULL);
+	parallel.rng = *rng;
+	parallel.format = out->format;
+	parallel.fd = out->fd;
+	parallel.flush_size = out->flush_size;
+	parallel.compress = out->compress;
+	parallel.level = out->level;
+	parallel.database = database;
+	parallel.map = out->map;
+	parallel.map_size = out->map_size;
+	parallel.map_len = out->map_len;
+	parallel.uring = out->uring;
+	parallel.columnar = columnar;
+	parallel.checkpoint = out->checkpoint;
+	parallel.progress = progress;
+	parallel.table = table;
+	parallel.delimiter = delimiter;
+	parallel.multiplier = multiplier;
+	parallel.threads = threads;
+	/* Columnar blocks are whole row groups. */
+	parallel.block_rows =
+			out->format == FORMAT_COLUMNAR ? ROW_GROUP_ROWS : BLOCK_ROWS;
+	parallel.first_row = first_row;
+	parallel.last_row = last_row;
+
+	for (i = 0; i < threads; i++) {
+		worker[i].id = i;
+		worker[i].parallel = &parallel;
+		if (pthread_create(&worker[i].tid, NULL, generate_worker,
+				&worker[i]) != 0) {
+			fprintf(stderr, "ERROR: cannot create thread %d\n", i);
+			pthread_mutex_lock(&parallel.lock);
+			parallel.error = 1;
+			pthread_cond_broadcast(&parallel.cond);
+			pthread_mutex_unlock(&parallel.lock);
+			threads = i;
+			break;
+		}
+	}
+
+	for (i = 0; i < threads; i++)
+		pthread_join(worker[i].tid, NULL);
+
+	pthread_cond_destroy(&parallel.cond);
+	pthread_mutex_destroy(&parallel.lock);
+	free(worker);
+	out->map_len = parallel.map_len;
+
+	return parallel.error;
+}
+
+int generate_serial(pcg64f_random_t *rng, struct output_t *out,
+		struct columnar_t *columnar, struct table_definition_t *table,
+		char delimiter, int multiplier, long long first_row,
+		long long last_row)
+{
+	struct batch_t batch;
+	struct row_group_t rg;
+	long long row;
+	long long block_rows = ROW_GROUP_ROWS;
+	int rc;
+
+	/* Version 3 data does not use the prng, each row is computed directly. */
+	if (table->version < DATA_VERSION_3)
+		pcg64f_advance_r(rng, first_row * multiplier);
+
+	memset(&rg, 0, sizeof(struct row_group_t));
+	rc = batch_init(&batch, table, multiplier);
+	if (rc == 0 && out->format == FORMAT_COLUMNAR)
+		rc = row_group_init(&rg, table);
+
+	for (row = first_row; rc == 0 && row < last_row; row += block_rows) {
+		if (row + block_rows > last_row)
+			block_rows = last_row - row;
+		rc = generate_rows(rng, table, &batch, out, &rg, delimiter, row,
+				row + block_rows);
+		if (rc == 0 && out->format == FORMAT_COLUMNAR)
+			rc = columnar_write_row_group(columnar, &rg);
+	}
+
+	row_group_free(&rg, table);
+	batch_free(&batch, table);
+
+	return rc;
+}
+
+int generate_data(pcg64f_random_t *rng, int format, int fd,
+		size_t flush_size, int compress, int level,
+		struct database_t *database, int io,
+		struct table_definition_t *table, char delimiter,
+		long long first_row, long long last_row, int threads,
+		struct checkpoint_t *checkpoint, struct progress_t *progress)
+{
+	struct output_t out;
+	struct columnar_t columnar;
+	struct uring_t uring;
+	int multiplier;
+	int rc;
+
+	/* Calculate how far to advance the prng based on the column types. */
+	multiplier = prng_multiplier(table);
+	if (multiplier < 0)
+		return 1;
+
+	memset(&columnar, 0, sizeof(struct columnar_t));
+	rc = output_init(&out, format, fd, flush_size);
+	if (rc != 0)
+		return rc;
+	out.compress = compress;
+	out.level = level;
+
+	/* Threads count their own progress, else it is all in out. */
+	if (progress != NULL) {
+		rc = progress_start(progress, threads > 1 || (database == NULL &&
+				io == IO_MMAP) ? threads : 1);
+		if (rc != 0) {
+			output_free(&out);
+			return rc;
+		}
+		if (threads == 1 && (database != NULL || io != IO_MMAP))
+			out.progress = progress;
+	}
+
+	if (database != NULL) {
+		/* Each thread has its own COPY, else use just the one. */
+		if (threads > 1)
+			rc = generate_parallel(rng, &out, database, &columnar, table,
+					delimiter, multiplier, first_row, last_row, threads,
+					progress);
+		else {
+			rc = copy_start(&out, database);
+			if (rc == 0)
+				rc = generate_serial(rng, &out, &columnar, table, delimiter,
+						multiplier, first_row, last_row);
+			if (out.conn != NULL)
+				rc = copy_end(&out, rc);
+		}
+		if (progress != NULL)
+			progress_stop(progress);
+		output_free(&out);
+		return rc;
+	}
+
+	/* Size the file for the header, trailer and the largest possible rows. */
+	if (io == IO_MMAP)
+		rc = output_map_open(&out, 21 + (size_t) (last_row - first_row) *
+				row_size_bound(table, format));
+	/* Fall back to write() if io_uring cannot be used. */
+	if (io == IO_URING || io == IO_URING_DIRECT) {
+		if (uring_init(&uring, fd, flush_size, io == IO_URING_DIRECT) == 0)
+			out.uring = &uring;
+		else
+			uring_free(&uring);
+	}
+	/* A resumed data file already has its header. */
+	out.checkpoint = checkpoint;
+	if (rc == 0 && (checkpoint == NULL || !checkpoint->resume))
+		rc = output_header(&out);
+	if (rc == 0 && format == FORMAT_COLUMNAR)
+		rc = columnar_init(&columnar, &out, table);
+
+	if (rc == 0 && (threads > 1 || io == IO_MMAP)) {
+		/* Write the header before the threads write their blocks. */
+		rc = output_flush(&out);
+		if (rc == 0)
+			rc = generate_parallel(rng, &out, NULL, &columnar, table,
+					delimiter, multiplier, first_row, last_row, threads,
+					progress);
+	} else if (rc == 0)
+		rc = generate_serial(rng, &out, &columnar, table, delimiter,
+				multiplier, first_row, last_row);
+
+	if (rc == 0 && format == FORMAT_COLUMNAR)
+		rc = columnar_finish(&columnar);
+	if (rc == 0)
+		rc = output_trailer(&out);
+	if (rc == 0)
+		rc = output_flush(&out);
+	if (rc == 0)
+		rc = checkpoint_write(checkpoint, last_row, 1);
+	if (out.map != NULL && output_map_close(&out) != 0)
+		rc = 1;
+	if (out.uring != NULL) {
+		if (rc == 0)
+			rc = uring_finish(&uring);
+		uring_free(&uring);
+	}
+	if (progress != NULL)
+		progress_stop(progress);
+	columnar_free(&columnar);
+	output_free(&out);
+
+	return rc;
+}
+
+/* State of compiling an expression by recursive descent. */
+struct compiler_t
+{
+	const char *p;
+	struct table_definition_t *table;
+	int col;
+	struct expression_t *e;
+	int depth;
+	int kind[MAX_EXPRESSION_DEPTH]; /* Value kinds on the stack. */
+	int randoms;
+};
+
+/*
+ * Append an operation, checking the stack depth and working out the kind of
+ * its result: a date plus or minus days is a date, the days between two dates
+ * is an integer, and nothing else can be done to a date.
+ */
+int compile_op(struct compiler_t *c, int code, long long arg1,
+		long long arg2, int kind)
+{
+	int x, y;
+
+	if (c->e->ops == MAX_EXPRESSION_OPS) {
+		fprintf(stderr, "ERROR: more than %d operations in expression\n",
+				MAX_EXPRESSION_OPS);
+		return 1;
+	}
+
+	switch (code) {
+	case OP_CONSTANT:
+	case OP_COLUMN:
+	case OP_RANDOM:
+		if (c->depth == MAX_EXPRESSION_DEPTH) {
+			fprintf(stderr, "ERROR: expression nested too deeply\n");
+			return 1;
+		}
+		c->kind[c->depth++] = kind;
+		break;
+	case OP_NEGATE:
+		if (c->kind[c->depth - 1] == VALUE_DATE) {
+			fprintf(stderr, "ERROR: cannot negate a date\n");
+			return 1;
+		}
+		break;
+	default:
+		x = c->kind[c->depth - 2];
+		y = c->kind[c->depth - 1];
+		--c->depth;
+		if (x == VALUE_DATE && y == VALUE_DATE && code == OP_SUBTRACT)
+			kind = VALUE_INTEGER;
+		else if ((x == VALUE_DATE) != (y == VALUE_DATE) && code == OP_ADD)
+			kind = VALUE_DATE;
+		else if (x == VALUE_DATE && y == VALUE_INTEGER &&
+				code == OP_SUBTRACT)
+			kind = VALUE_DATE;
+		else if (x == VALUE_DATE || y == VALUE_DATE) {
+			fprintf(stderr, "ERROR: can only add days to or subtract dates\n");
+			return 1;
+		} else
+			kind = VALUE_INTEGER;
+		c->kind[c->depth - 1] = kind;
+		break;
+	}
+
+	c->e->op[c->e->ops].code = code;
+	c->e->op[c->e->ops].arg1 = arg1;
+	c->e->op[c->e->ops].arg2 = arg2;
+	++c->e->ops;
+
+	return 0;
+}
+
+static inline int compile_next(struct compiler_t *c)
+{
+	while (isspace((unsigned char) *c->p))
+		++c->p;
+	return *c->p;
+}
+
+int compile_sum(struct compiler_t *);
+
+/* primary := <integer> | $<column> | random(<min>,<max>) | ( sum ) */
+int compile_primary(struct compiler_t *c)
+{
+	struct column_t *column;
+	long long min, max;
+	char *end;
+	char type;
+	int n;
+
+	if (compile_next(c) == '(') {
+		++c->p;
+		if (compile_sum(c) != 0)
+			return 1;
+		if (compile_next(c) != ')') {
+			fprintf(stderr, "ERROR: missing ) in expression\n");
+			return 1;
+		}
+		++c->p;
+		return 0;
+	}
+
+	if (*c->p == '$') {
+		errno = 0;
+		min = strtoll(c->p + 1, &end, 10);
+		if (end == c->p + 1 || errno != 0 || min < 1 || min > c->col) {
+			fprintf(stderr, "ERROR: expression can only use earlier "
+					"columns\n");
+			return 1;
+		}
+		c->p = end;
+		--min;
+		column = &c->table->column[min];
+		type = value_type(c->table, min);
+		if (type == TYPE_LIST || type == TYPE_TEXT ||
+				type == TYPE_TIMESTAMP || type == TYPE_TIMESTAMPTZ ||
+				type == TYPE_WEIGHTED_LIST || type == TYPE_WORDS) {
+			fprintf(stderr, "ERROR: expression cannot use column %lld of "
+					"type %c\n", min + 1, type);
+			return 1;
+		}
+		if (column->nullable)
+			c->table->column[c->col].nullable = 1;
+		return compile_op(c, OP_COLUMN, min, 0,
+				type == TYPE_DATE ? VALUE_DATE : VALUE_INTEGER);
+	}
+
+	if (strncmp(c->p, "random", 6) == 0) {
+		/* All of a column's random values come from the row's one number. */
+		if (c->randoms++ > 0) {
+			fprintf(stderr, "ERROR: expression can only use random() "
+					"once\n");
+			return 1;
+		}
+		n = -1;
+		if (sscanf(c->p + 6, " ( %lld , %lld )%n", &min, &max, &n) != 2 ||
+				n == -1 || max < min) {
+			fprintf(stderr, "ERROR: invalid random() in expression\n");
+			return 1;
+		}
+		c->p += 6 + n;
+		return compile_op(c, OP_RANDOM, min, max, VALUE_INTEGER);
+	}
+
+	errno = 0;
+	min = strtoll(c->p, &end, 10);
+	if (end == c->p || errno != 0) {
+		fprintf(stderr, "ERROR: unexpected %.*s in expression\n",
+				*c->p == '\0' ? 3 : (int) strcspn(c->p, "\n"),
+				*c->p == '\0' ? "end" : c->p);
+		return 1;
+	}
+	c->p = end;
+	return compile_op(c, OP_CONSTANT, min, 0, VALUE_INTEGER);
+}
+
+/* unary := - unary | primary */
+int compile_unary(struct compiler_t *c)
+{
+	if (compile_next(c) == '-') {
+		++c->p;
+		if (compile_unary(c) != 0)
+			return 1;
+		return compile_op(c, OP_NEGATE, 0, 0, 0);
+	}
+	return compile_primary(c);
+}
+
+/* product := unary { (* | / | %) unary } */
+int compile_product(struct compiler_t *c)
+{
+	int code;
+
+	if (compile_unary(c) != 0)
+		return 1;
+	while (1) {
+		switch (compile_next(c)) {
+		case '*':
+			code = OP_MULTIPLY;
+			break;
+		case '/':
+			code = OP_DIVIDE;
+			break;
+		case '%':
+			code = OP_MODULO;
+			break;
+		default:
+			return 0;
+		}
+		++c->p;
+		if (compile_unary(c) != 0 || compile_op(c, code, 0, 0, 0) != 0)
+			return 1;
+	}
+}
+
+/* sum := product { (+ | -) product } */
+int compile_sum(struct compiler_t *c)
+{
+	int code;
+
+	if (compile_product(c) != 0)
+		return 1;
+	while (1) {
+		switch (compile_next(c)) {
+		case '+':
+			code = OP_ADD;
+			break;
+		case '-':
+			code = OP_SUBTRACT;
+			break;
+		default:
+			return 0;
+		}
+		++c->p;
+		if (compile_product(c) != 0 || compile_op(c, code, 0, 0, 0) != 0)
+			return 1;
+	}
+}
+
+/* Compile the expression of a column so rows are generated without parsing. */
+int compile_expression(struct table_definition_t *table, int col,
+		const char *text)
+{
+	struct compiler_t c;
+
+	memset(&c, 0, sizeof(struct compiler_t));
+	c.p = text;
+	c.table = table;
+	c.col = col;
+	c.e = (struct expression_t *) &table->column[col].arguments;
+	memset(c.e, 0, sizeof(struct expression_t));
+
+	if (compile_sum(&c) != 0)
+		return 1;
+	if (compile_next(&c) != '\0') {
+		fprintf(stderr, "ERROR: unexpected %.*s in expression\n",
+				(int) strcspn(c.p, "\n"), c.p);
+		return 1;
+	}
+	c.e->kind = c.kind[0];
+
+	return 0;
+}
+
+/*
+ * Check a numeric column has integer values, and that their range fits in the
+ * precision.  Columns without a bounded range, such as expressions, cannot be
+ * numeric.
+ */
+int check_numeric(struct table_definition_t *table, int col)
+{
+	struct column_t *column = &table->column[col];
+	struct reference_t *ref;
+	struct zipfian_t *zipfian;
+	long long min, max;
+	long long limit = 1;
+	int precision = column->precision;
+	int i;
+
+	/* A reference has the range of its column in the referenced table. */
+	if (column->type == TYPE_REFERENCE) {
+		ref = (struct reference_t *) &column->arguments;
+		/* Not followed in a table only read to be referenced. */
+		if (ref->table == NULL)
+			return 0;
+		table = ref->table;
+		column = &table->column[ref->column];
+	}
+
+	switch (column->type) {
+	/* These all start with their minimum and maximum. */
+	case TYPE_EXPONENTIAL:
+	case TYPE_GAUSSIAN:
+	case TYPE_HOTSPOT:
+	case TYPE_INTEGER:
+	case TYPE_UNIQUE:
+		min = ((struct integer_t *) &column->arguments)->arg1;
+		max = ((struct integer_t *) &column->arguments)->arg2;
+		break;
+	case TYPE_SEQUENCE:
+		min = ((struct sequence_t *) &column->arguments)->arg1;
+		max = min > LLONG_MAX - (table->rows - 1) ? LLONG_MAX :
+				min + (table->rows - 1);
+		break;
+	case TYPE_ZIPFIAN:
+		zipfian = (struct zipfian_t *) &column->arguments;
+		min = zipfian->min;
+		max = zipfian->min + (zipfian->n - 1);
+		break;
+	case TYPE_EXPRESSION:
+	case TYPE_POISSON:
+		fprintf(stderr, "ERROR: numeric needs a bounded range\n");
+		return 1;
+	default:
+		fprintf(stderr, "ERROR: numeric needs integer values\n");
+		return 1;
+	}
+
+	for (i = 0; i < precision; i++)
+		limit *= 10;
+	if (min <= -limit || max >= limit) {
+		fprintf(stderr, "ERROR: range needs more than %d digits\n",
+				precision);
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Read a timestamp as microseconds since 1970-01-01 from text of the form
+ * Y-M-D with an optional time H:M:S after a T or a space, and optional
+ * fraction of a second.  Returns the number of characters read, or -1.
+ */
+int read_timestamp(const char *text, long long *usec)
+{
+	int year, month, day;
+	int hour = 0, minute = 0, second = 0;
+	long long fraction = 0;
+	int n, m;
+	int i;
+
+	if (sscanf(text, "%d-%d-%d%n", &year, &month, &day, &n) != 3 ||
+			month < 1 || month > 12 || day < 1 || day > 31)
+		return -1;
+	if ((text[n] == 'T' || text[n] == ' ') &&
+			isdigit((unsigned char) text[n + 1])) {
+		if (sscanf(text + n + 1, "%d:%d:%d%n", &hour, &minute, &second,
+				&m) != 3 || hour > 23 || minute > 59 || second > 59 ||
+				hour < 0 || minute < 0 || second < 0)
+			return -1;
+		n += 1 + m;
+		if (text[n] == '.') {
+			for (i = 0, ++n; isdigit((unsigned char) text[n]); i++, n++)
+				if (i < 6)
+					fraction = fraction * 10 + text[n] - '0';
+			for (; i < 6; i++)
+				fraction *= 10;
+		}
+	}
+
+	*usec = ((long long) days_from_civil(year, month, day) * 86400 +
+			hour * 3600 + minute * 60 + second) * 1000000 + fraction;
+	return n;
+}
+
+/*
+ * Read the modifiers of a column, separated by semicolons: null=<percent> for
+ * the chance of a NULL, numeric=<precision>,<scale> to write integers as
+ * units of 10^-scale, and distinct=<n> for the number of distinct values.
+ */
+int read_modifiers(struct table_definition_t *table, int col, char *text)
+{
+	struct column_t *column = &table->column[col];
+	double percent;
+	char *token;
+	char *save;
+	int n;
+
+	for (token = strtok_r(text, ";", &save); token != NULL;
+			token = strtok_r(NULL, ";", &save)) {
+		n = -1;
+		if (sscanf(token, " null = %lf %n", &percent, &n) == 1 && n != -1 &&
+				token[n] == '\0' && percent > 0 && percent <= 100) {
+			column->nulls = percent == 100 ? ULLONG_MAX :
+					(unsigned long long) (percent / 100 * 0x1.0p64);
+			column->null_key = column_key(table->key, KEY_NULL, col);
+		} else if (sscanf(token, " numeric = %d , %d %n", &column->precision,
+				&column->scale, &n) == 2 && n != -1 && token[n] == '\0' &&
+				column->precision > 0 &&
+				column->precision <= MAX_NUMERIC_PRECISION &&
+				column->scale >= 0 && column->scale <= column->precision)
+			continue;
+		else if (sscanf(token, " distinct = %lld %n", &column->distinct,
+				&n) == 1 && n != -1 && token[n] == '\0' &&
+				column->distinct > 0)
+			column->distinct_key = column_key(table->key,
+					KEY_DISTINCT, col);
+		else {
+			fprintf(stderr, "ERROR: invalid column modifier: %s\n", token);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int read_data_definition_file(struct table_definition_t *table, char *filename)
+{
+	FILE *f;
+	char *line = NULL;
+	size_t len = 0;
+	ssize_t nread;
+	int *column;
+	int rc;
+	int n;
+	char *p;
+	struct reference_t *ref;
+	struct words_t *words;
+	struct list_t *list;
+	long long min, max;
+	double exponent;
+	double hot_draws, hot_keys;
+
+	fprintf(stderr, "reading %s\n", filename);
+
+	f = fopen(filename, "r");
+	if (f == NULL) {
+		fprintf(stderr, "ERROR: cannot open data definition file [%d]: %s\n",
+				errno, filename);
+		return 1;
+	}
+
+	/* Read just the first line for the table cardinality. */
+
+	nread = getline(&line, &len, f);
+	if (nread == -1) {
+		fprintf(stderr, "ERROR: no data on first line of ddf?: %d",
+				errno);
+		return 2;
+	}
+	/* Hash everything the data depends on so resuming can check it. */
+	table->hash = hash_bytes(0xcbf29ce484222325ULL, line, nread);
+	errno = 0;
+	table->rows = strtoll(line, NULL, 10);
+	if (errno != 0 || table->rows == 0) {
+		fprintf(stderr, "ERROR: number of rows invalid [errno %d]: %s\n",
+				errno, line);
+		free(line);
+		fclose(f);
+		return 5;
+	}
+
+	fprintf(stderr, "%lld row(s)\n", table->rows);
+
+	/* Read the column definition from rest of the file. */
+
+	fprintf(stderr, "column definitions:\n");
+	while ((nread = getline(&line, &len, f)) != -1) {
+		column = &table->columns;
+
+		if (nread == 0) {
+			fprintf(stderr, "ERROR: empty line in data definition file file, "
+					"aborting\n");
+			free(line);
+			fclose(f);
+			return 4;
+		}
+
+		fprintf(stderr, "[%d] %s", table->columns + 1, line);
+		table->hash = hash_bytes(table->hash, line, nread);
+
+		/* Modifiers of any column follow its arguments. */
+		p = strchr(line, ';');
+		if (p != NULL) {
+			*p = '\0';
+			if (read_modifiers(table, *column, p + 1) != 0) {
+				free(line);
+				fclose(f);
+				return 7;
+			}
+		}
 
 		table->column[table->columns].type = line[0];
 		switch (line[0]) {
@@ -322,6 +3778,15 @@ int read_data_definition_file(struct table_definition_t *table, char *filename)
 				fclose(f);
 				return 7;
 			}
+			/* struct tm counts years from 1900 and months from 0. */
+			((struct date_t *)
+					&table->column[*column].arguments)->arg1.tm_year -= 1900;
+			((struct date_t *)
+					&table->column[*column].arguments)->arg1.tm_mon -= 1;
+			((struct date_t *)
+					&table->column[*column].arguments)->arg2.tm_year -= 1900;
+			((struct date_t *)
+					&table->column[*column].arguments)->arg2.tm_mon -= 1;
 			((struct date_t *) &table->column[*column].arguments)->tloc1 =
 					mktime(&((struct date_t *)
 							&table->column[*column].arguments)->arg1);
@@ -348,6 +3813,17 @@ int read_data_definition_file(struct table_definition_t *table, char *filename)
 				return 7;
 			}
 			break;
+		case TYPE_EXPRESSION:
+			rc = compile_expression(table, *column, line + 1);
+			if (rc != 0) {
+				fprintf(stderr,
+						"ERROR: invalid argument to expression: %s\n",
+						line + 1);
+				free(line);
+				fclose(f);
+				return 7;
+			}
+			break;
 		case TYPE_GAUSSIAN:
 			rc = sscanf(line + 1, "%lld,%lld,%lf",
 					&((struct gaussian_t *)
@@ -365,6 +3841,29 @@ int read_data_definition_file(struct table_definition_t *table, char *filename)
 				return 7;
 			}
 			break;
+		case TYPE_HOTSPOT:
+			rc = sscanf(line + 1, "%lld,%lld,%lf,%lf", &min, &max, &hot_draws,
+					&hot_keys);
+			if (rc != 4 || max < min || hot_draws < 0 || hot_draws > 100 ||
+					hot_keys <= 0 || hot_keys > 100) {
+				fprintf(stderr,
+						"ERROR: invalid argument to hotspot: %s\n",
+						line + 1);
+				free(line);
+				fclose(f);
+				return 7;
+			}
+			((struct hotspot_t *)
+					&table->column[*column].arguments)->arg1 = min;
+			((struct hotspot_t *)
+					&table->column[*column].arguments)->arg2 = max;
+			((struct hotspot_t *)
+					&table->column[*column].arguments)->arg3 =
+							hot_draws / 100.0;
+			((struct hotspot_t *)
+					&table->column[*column].arguments)->arg4 =
+							hot_keys / 100.0;
+			break;
 		case TYPE_INTEGER:
 			rc = sscanf(line + 1, "%lld,%lld",
 					&((struct integer_t *)
@@ -393,141 +3892,922 @@ int read_data_definition_file(struct table_definition_t *table, char *filename)
 				return 7;
 			}
 
-			rc = read_list((struct list_t *)
-					&table->column[*column].arguments);
-			if (rc != 0)
-				return 7;
+			rc = read_list((struct list_t *)
+					&table->column[*column].arguments);
+			if (rc != 0)
+				return 7;
+
+			break;
+		case TYPE_WEIGHTED_LIST:
+			memset(((struct list_t *) &table->column[*column].arguments),
+					0, sizeof(struct list_t));
+			rc = sscanf(line + 1, "%s",
+					((struct list_t *)
+							&table->column[*column].arguments)->filename);
+			if (rc != 1) {
+				fprintf(stderr,
+						"ERROR: invalid argument to weighted list: %s\n",
+						line + 1);
+				free(line);
+				fclose(f);
+				return 7;
+			}
+
+			rc = read_list((struct list_t *)
+					&table->column[*column].arguments);
+			if (rc == 0)
+				rc = read_weights((struct list_t *)
+						&table->column[*column].arguments);
+			if (rc != 0)
+				return 7;
+
+			break;
+		case TYPE_WORDS:
+			words = (struct words_t *) &table->column[*column].arguments;
+			memset(words, 0, sizeof(struct words_t));
+			rc = sscanf(line + 1, "%[^,],%d,%d", words->list.filename,
+					&words->arg1, &words->arg2);
+			if (rc != 3 || words->arg1 < 0 || words->arg2 < words->arg1) {
+				fprintf(stderr, "ERROR: invalid argument to words: %s\n",
+						line + 1);
+				free(line);
+				fclose(f);
+				return 7;
+			}
+
+			rc = read_words(words);
+			if (rc != 0)
+				return 7;
+
+			break;
+		case TYPE_POISSON:
+			rc = sscanf(line + 1, "%lld",
+					&((struct poisson_t *)
+							&table->column[*column].arguments)->arg1);
+			if (rc != 1) {
+				fprintf(stderr,
+						"ERROR: invalid argument to poisson: %s\n",
+						line + 1);
+				free(line);
+				fclose(f);
+				return 7;
+			}
+			break;
+		case TYPE_REFERENCE:
+			rc = sscanf(line + 1, "%[^.].%d",
+					((struct reference_t *)
+							&table->column[*column].arguments)->name,
+					&((struct reference_t *)
+							&table->column[*column].arguments)->column);
+			if (rc != 2 || ((struct reference_t *)
+					&table->column[*column].arguments)->column < 1) {
+				fprintf(stderr,
+						"ERROR: invalid argument to reference: %s\n",
+						line + 1);
+				free(line);
+				fclose(f);
+				return 7;
+			}
+			/* Columns are counted from 1 in the data definition file. */
+			--((struct reference_t *)
+					&table->column[*column].arguments)->column;
+
+			if (table->referenced)
+				break;
+			rc = read_reference(table, (struct reference_t *)
+					&table->column[*column].arguments, filename);
+			if (rc != 0)
+				return 7;
+
+			/* A reference to a numeric is numeric unless it has its own. */
+			ref = (struct reference_t *) &table->column[*column].arguments;
+			table->hash = hash_bytes(table->hash, &ref->table->hash,
+					sizeof(ref->table->hash));
+			if (table->column[*column].precision == 0) {
+				table->column[*column].precision =
+						ref->table->column[ref->column].precision;
+				table->column[*column].scale =
+						ref->table->column[ref->column].scale;
+			}
+
+			break;
+		case TYPE_SEQUENCE:
+			rc = sscanf(line + 1, "%d",
+					&((struct text_t *)
+							&table->column[*column].arguments)->arg1);
+			if (rc != 1) {
+				fprintf(stderr,
+						"ERROR: invalid argument to sequence: %s\n", line + 1);
+				free(line);
+				fclose(f);
+				return 7;
+			}
+			break;
+		case TYPE_TEXT:
+			rc = sscanf(line + 1, "%d,%d",
+					&((struct text_t *)
+							&table->column[*column].arguments)->arg1,
+					&((struct text_t *)
+							&table->column[*column].arguments)->arg2);
+			if (rc != 2) {
+				fprintf(stderr, "ERROR: invalid argument to text: %s\n",
+						line + 1);
+				free(line);
+				fclose(f);
+				return 7;
+			}
+			break;
+		case TYPE_TIMESTAMP:
+		case TYPE_TIMESTAMPTZ:
+			n = read_timestamp(line + 1, &min);
+			rc = n == -1 || line[1 + n] != ',' ? -1 :
+					read_timestamp(line + 2 + n, &max);
+			if (rc == -1 || max <= min) {
+				fprintf(stderr,
+						"ERROR: invalid argument to timestamp: %s\n",
+						line + 1);
+				free(line);
+				fclose(f);
+				return 7;
+			}
+			((struct timestamp_t *)
+					&table->column[*column].arguments)->arg1 = min;
+			((struct timestamp_t *)
+					&table->column[*column].arguments)->arg2 = max;
+			break;
+		case TYPE_UNIQUE:
+			rc = sscanf(line + 1, "%lld,%lld", &min, &max);
+			if (rc != 2 || max < min) {
+				fprintf(stderr, "ERROR: invalid argument to unique: %s\n",
+						line + 1);
+				free(line);
+				fclose(f);
+				return 7;
+			}
+			/* The whole range of 64-bit integers wraps around to 0. */
+			if ((unsigned long long) max - min + 1 != 0 &&
+					(unsigned long long) max - min + 1 <
+							(unsigned long long) table->rows) {
+				fprintf(stderr, "ERROR: unique range has fewer than %lld "
+						"values: %s\n", table->rows, line + 1);
+				free(line);
+				fclose(f);
+				return 7;
+			}
+			((struct unique_t *)
+					&table->column[*column].arguments)->arg1 = min;
+			((struct unique_t *)
+					&table->column[*column].arguments)->arg2 = max;
+			((struct unique_t *) &table->column[*column].arguments)->key =
+					column_key(table->key, KEY_UNIQUE, *column);
+			break;
+		case TYPE_ZIPFIAN:
+			rc = sscanf(line + 1, "%lld,%lld,%lf", &min, &max, &exponent);
+			if (rc != 3 || max < min || exponent <= 0) {
+				fprintf(stderr,
+						"ERROR: invalid argument to zipfian: %s\n",
+						line + 1);
+				free(line);
+				fclose(f);
+				return 7;
+			}
+			setZipfian((struct zipfian_t *) &table->column[*column].arguments,
+					min, max, exponent);
+			break;
+		default:
+			fprintf(stderr, "ERROR: unrecognized column definition: %s\n",
+					line);
+			free(line);
+			fclose(f);
+			return 6;
+		}
+
+		if (table->column[*column].distinct != 0 &&
+				(line[0] == TYPE_SEQUENCE || line[0] == TYPE_UNIQUE)) {
+			fprintf(stderr, "ERROR: distinct cannot be used with unique "
+					"values: %s\n", line);
+			free(line);
+			fclose(f);
+			return 7;
+		}
+		/* Words columns keep their sample text in a list too. */
+		if (line[0] == TYPE_LIST || line[0] == TYPE_WEIGHTED_LIST ||
+				line[0] == TYPE_WORDS) {
+			list = (struct list_t *) &table->column[*column].arguments;
+			table->hash = hash_bytes(table->hash, list->arena,
+					list->arena_size);
+		}
+		if (table->column[*column].nulls != 0)
+			table->column[*column].nullable = 1;
+		if (table->column[*column].precision != 0 &&
+				check_numeric(table, *column) != 0) {
+			fprintf(stderr, "ERROR: invalid numeric column: %s\n", line);
+			free(line);
+			fclose(f);
+			return 7;
+		}
+
+		++(*column);
+	}
+
+	free(line);
+	fclose(f);
+
+	if (table->columns == 0) {
+		fprintf(stderr, "ERROR: no columns defined\n");
+		return 3;
+	}
+
+	if (table->columns > MAX_COLS) {
+		fprintf(stderr, "ERROR: more than %d columns defined\n", MAX_COLS);
+		return 3;
+	}
+
+	fprintf(stderr, "%d column(s)\n", *column);
+
+	return 0;
+}
+
+int read_list(struct list_t *list)
+{
+	struct stat st;
+	const char *p, *end, *eol;
+	int fd;
+	int i;
+
+	fd = open(list->filename, O_RDONLY);
+	if (fd == -1) {
+		fprintf(stderr, "ERROR: cannot open list file: %s\n", list->filename);
+		return 1;
+	}
+
+#ifdef ENABLE_CASSERT
+	fprintf(stderr, "reading list file: %s\n", list->filename);
+#endif /* ENABLE_CASSERT */
+
+	if (fstat(fd, &st) == -1 || st.st_size == 0) {
+		fprintf(stderr, "ERROR: list file is empty: %s\n", list->filename);
+		close(fd);
+		return 1;
+	}
+	list->arena_size = st.st_size;
+	list->arena = (char *) mmap(NULL, list->arena_size, PROT_READ,
+			MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (list->arena == MAP_FAILED) {
+		fprintf(stderr, "ERROR: cannot map list file [%d]: %s\n", errno,
+				list->filename);
+		return 1;
+	}
+	end = list->arena + list->arena_size;
+
+	/* Count the lines to size the index, the last may have no newline. */
+	list->size = 0;
+	for (p = list->arena; p < end; p = eol + 1) {
+		++list->size;
+		eol = memchr(p, '\n', end - p);
+		if (eol == NULL)
+			break;
+	}
+
+	list->offset = (size_t *) malloc(sizeof(size_t) * list->size);
+	list->length = (int *) malloc(sizeof(int) * list->size);
+	if (list->offset == NULL || list->length == NULL) {
+		fprintf(stderr, "ERROR: cannot allocate index for %d lines of list "
+				"file: %s\n", list->size, list->filename);
+		return 1;
+	}
+
+	list->max_length = 0;
+	for (i = 0, p = list->arena; i < list->size; i++, p = eol + 1) {
+		eol = memchr(p, '\n', end - p);
+		if (eol == NULL)
+			eol = end;
+		list->offset[i] = p - list->arena;
+		list->length[i] = (int) (eol - p);
+		if (list->length[i] > list->max_length)
+			list->max_length = list->length[i];
+#ifdef ENABLE_CASSERT
+		fprintf(stderr, "%.*s\n", list->length[i], p);
+#endif /* ENABLE_CASSERT */
+	}
+
+	return 0;
+}
+
+/*
+ * Build the alias table for a weighted list with Vose's method: lines picked
+ * less often than average give the rest of their share to one picked more
+ * often, so that each line takes the same share of a single random number.
+ */
+int build_alias(struct list_t *list, double *weight, double total)
+{
+	double *probability;
+	int *small, *large;
+	int nsmall = 0, nlarge = 0;
+	int i, j;
+
+	list->probability = (double *) malloc(sizeof(double) * list->size);
+	list->alias = (int *) malloc(sizeof(int) * list->size);
+	small = (int *) malloc(sizeof(int) * list->size);
+	large = (int *) malloc(sizeof(int) * list->size);
+	if (list->probability == NULL || list->alias == NULL || small == NULL ||
+			large == NULL) {
+		fprintf(stderr, "ERROR: cannot allocate alias table for %d lines of "
+				"list file: %s\n", list->size, list->filename);
+		free(small);
+		free(large);
+		return 1;
+	}
+	probability = list->probability;
+
+	for (i = 0; i < list->size; i++) {
+		probability[i] = weight[i] * list->size / total;
+		list->alias[i] = i;
+		if (probability[i] < 1.0)
+			small[nsmall++] = i;
+		else
+			large[nlarge++] = i;
+	}
+
+	while (nsmall > 0 && nlarge > 0) {
+		i = small[--nsmall];
+		j = large[--nlarge];
+		list->alias[i] = j;
+		probability[j] += probability[i] - 1.0;
+		if (probability[j] < 1.0)
+			small[nsmall++] = j;
+		else
+			large[nlarge++] = j;
+	}
+	/* Whatever is left is only off from 1 by rounding. */
+	while (nlarge > 0)
+		probability[large[--nlarge]] = 1.0;
+	while (nsmall > 0)
+		probability[small[--nsmall]] = 1.0;
+
+	free(small);
+	free(large);
+	return 0;
+}
+
+/*
+ * Each line of a weighted list starts with its weight and a comma.  Take the
+ * weights off the lines and build the alias table from them.
+ */
+int read_weights(struct list_t *list)
+{
+	char buf[MAX_WEIGHT_LEN];
+	const char *p, *comma;
+	double *weight;
+	double total = 0;
+	char *end;
+	int rc;
+	int n;
+	int i;
+
+	weight = (double *) malloc(sizeof(double) * list->size);
+	if (weight == NULL) {
+		fprintf(stderr, "ERROR: cannot allocate weights for %d lines of list "
+				"file: %s\n", list->size, list->filename);
+		return 1;
+	}
+
+	list->max_length = 0;
+	for (i = 0; i < list->size; i++) {
+		p = list->arena + list->offset[i];
+		comma = memchr(p, ',', list->length[i]);
+		n = comma == NULL ? 0 : (int) (comma - p);
+		if (n == 0 || n >= MAX_WEIGHT_LEN) {
+			fprintf(stderr, "ERROR: line %d of weighted list needs a weight "
+					"and a comma: %s\n", i + 1, list->filename);
+			free(weight);
+			return 1;
+		}
+
+		/* The arena is not null terminated, so parse a copy. */
+		memcpy(buf, p, n);
+		buf[n] = '\0';
+		weight[i] = strtod(buf, &end);
+		if (*end != '\0' || !(weight[i] >= 0) || isinf(weight[i])) {
+			fprintf(stderr, "ERROR: invalid weight on line %d of weighted "
+					"list: %s\n", i + 1, list->filename);
+			free(weight);
+			return 1;
+		}
+		total += weight[i];
+
+		list->offset[i] += n + 1;
+		list->length[i] -= n + 1;
+		if (list->length[i] > list->max_length)
+			list->max_length = list->length[i];
+	}
+
+	if (total <= 0) {
+		fprintf(stderr, "ERROR: weights of weighted list add up to 0: %s\n",
+				list->filename);
+		free(weight);
+		return 1;
+	}
+
+	rc = build_alias(list, weight, total);
+	free(weight);
+	return rc;
+}
+
+/*
+ * Read the data definition file of a referenced table, from the same
+ * directory as the file referencing it, and check the column can be
+ * referenced.
+ */
+int read_reference(struct table_definition_t *table, struct reference_t *ref,
+		char *filename)
+{
+	char tmp[FILENAME_MAX];
+	char ddf[FILENAME_MAX];
+	char type;
+	int col;
+
+	strncpy(tmp, filename, FILENAME_MAX - 1);
+	tmp[FILENAME_MAX - 1] = '\0';
+	if (snprintf(ddf, FILENAME_MAX, "%s/%s.ddf", dirname(tmp), ref->name) >=
+			FILENAME_MAX) {
+		fprintf(stderr, "ERROR: referenced table path is too long: %s\n",
+				ref->name);
+		return 1;
+	}
+
+	ref->table = (struct table_definition_t *) calloc(1,
+			sizeof(struct table_definition_t));
+	if (ref->table == NULL) {
+		fprintf(stderr, "ERROR: cannot allocate referenced table: %s\n",
+				ref->name);
+		return 1;
+	}
+	/* Generate the values the referenced table's own data has. */
+	ref->table->version = table->version;
+	ref->table->seed = table->seed;
+	ref->table->key = counter_random(table->seed, hash_name(ref->name));
+	ref->table->referenced = 1;
+	if (read_data_definition_file(ref->table, ddf) != 0)
+		return 1;
+
+	if (ref->column >= ref->table->columns) {
+		fprintf(stderr, "ERROR: table %s has no column %d\n", ref->name,
+				ref->column + 1);
+		return 1;
+	}
+	type = ref->table->column[ref->column].type;
+	if (type == TYPE_EXPRESSION || type == TYPE_LIST ||
+			type == TYPE_REFERENCE || type == TYPE_TEXT ||
+			type == TYPE_WEIGHTED_LIST || type == TYPE_WORDS) {
+		fprintf(stderr, "ERROR: cannot reference column %d of table %s of "
+				"type %c\n", ref->column + 1, ref->name, type);
+		return 1;
+	}
+	if (ref->table->column[ref->column].nullable) {
+		fprintf(stderr, "ERROR: cannot reference column %d of table %s with "
+				"NULLs\n", ref->column + 1, ref->name);
+		return 1;
+	}
+
+	ref->multiplier = prng_multiplier(ref->table);
+	if (ref->multiplier == -1)
+		return 1;
+	ref->draw = 0;
+	for (col = 0; col < ref->column; col++)
+		if (ref->table->column[col].type != TYPE_SEQUENCE &&
+				ref->table->column[col].type != TYPE_UNIQUE)
+			++ref->draw;
+	pcg64f_srandom_r(&ref->rng, table->seed);
+
+	return 0;
+}
+
+static inline int is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+/*
+ * Read the sample text of a words column and build its Markov chain.  Words
+ * are told apart with an open addressing hash table, then each occurrence of
+ * a word is counted under the word before it so the words following each
+ * word can be laid out together in next.
+ */
+int read_words(struct words_t *words)
+{
+	struct list_t *list = &words->list;
+	const char *p, *end;
+	unsigned long long hash;
+	unsigned long long mask;
+	int *table;
+	int *id;
+	int *fill;
+	int tokens = 0;
+	int n = 0;
+	int i, j, w;
 
-			break;
-		case TYPE_POISSON:
-			rc = sscanf(line + 1, "%lld",
-					&((struct poisson_t *)
-							&table->column[*column].arguments)->arg1);
-			if (rc != 1) {
-				fprintf(stderr,
-						"ERROR: invalid argument to poisson: %s\n",
-						line + 1);
-				free(line);
-				fclose(f);
-				return 7;
-			}
-			break;
-		case TYPE_SEQUENCE:
-			rc = sscanf(line + 1, "%d",
-					&((struct text_t *)
-							&table->column[*column].arguments)->arg1);
-			if (rc != 1) {
-				fprintf(stderr,
-						"ERROR: invalid argument to sequence: %s\n", line + 1);
-				free(line);
-				fclose(f);
-				return 7;
+	if (read_list(list) != 0)
+		return 1;
+
+	/* Count the words to size everything. */
+	for (i = 0; i < list->size; i++) {
+		p = list->arena + list->offset[i];
+		end = p + list->length[i];
+		for (j = 0; p + j < end; j++)
+			if (!is_space(p[j]) && (j == 0 || is_space(p[j - 1])))
+				++tokens;
+	}
+	if (tokens == 0) {
+		fprintf(stderr, "ERROR: words file has no words: %s\n",
+				list->filename);
+		return 1;
+	}
+
+	for (mask = 1; mask < (unsigned long long) tokens * 2; mask <<= 1)
+		;
+	table = (int *) malloc(sizeof(int) * mask--);
+	/* The words in order, with a -1 after the last word of each line. */
+	id = (int *) malloc(sizeof(int) * (tokens + list->size));
+	fill = (int *) malloc(sizeof(int) * tokens);
+	words->offset = (size_t *) malloc(sizeof(size_t) * tokens);
+	words->length = (int *) malloc(sizeof(int) * tokens);
+	words->first = (int *) calloc(tokens + 1, sizeof(int));
+	words->next = (int *) malloc(sizeof(int) * tokens);
+	words->start = (int *) malloc(sizeof(int) * list->size);
+	if (table == NULL || id == NULL || fill == NULL ||
+			words->offset == NULL || words->length == NULL ||
+			words->first == NULL || words->next == NULL ||
+			words->start == NULL) {
+		fprintf(stderr, "ERROR: cannot allocate index for %d words of words "
+				"file: %s\n", tokens, list->filename);
+		free(table);
+		free(id);
+		free(fill);
+		return 1;
+	}
+	memset(table, -1, sizeof(int) * (mask + 1));
+
+	words->words = 0;
+	words->starts = 0;
+	for (i = 0; i < list->size; i++) {
+		p = list->arena + list->offset[i];
+		end = p + list->length[i];
+		while (1) {
+			while (p < end && is_space(*p))
+				++p;
+			if (p == end)
+				break;
+
+			/* FNV-1a hash of the word, then look it up or add it. */
+			hash = 0xcbf29ce484222325ULL;
+			for (j = 0; p + j < end && !is_space(p[j]); j++) {
+				hash ^= (unsigned char) p[j];
+				hash *= 0x100000001b3ULL;
 			}
-			break;
-		case TYPE_TEXT:
-			rc = sscanf(line + 1, "%d,%d",
-					&((struct text_t *)
-							&table->column[*column].arguments)->arg1,
-					&((struct text_t *)
-							&table->column[*column].arguments)->arg2);
-			if (rc != 2) {
-				fprintf(stderr, "ERROR: invalid argument to text: %s\n",
-						line + 1);
-				free(line);
-				fclose(f);
-				return 7;
+			for (;; hash++) {
+				w = table[hash & mask];
+				if (w == -1) {
+					w = words->words++;
+					table[hash & mask] = w;
+					words->offset[w] = p - list->arena;
+					words->length[w] = j;
+					break;
+				}
+				if (words->length[w] == j &&
+						memcmp(list->arena + words->offset[w], p, j) == 0)
+					break;
 			}
-			break;
-		default:
-			fprintf(stderr, "ERROR: unrecognized column definition: %s\n",
-					line);
-			free(line);
-			fclose(f);
-			return 6;
+
+			if (n == 0 || id[n - 1] == -1)
+				words->start[words->starts++] = w;
+			id[n++] = w;
+			p += j;
 		}
+		if (n > 0 && id[n - 1] != -1)
+			id[n++] = -1;
+	}
 
-		++(*column);
+	/* Count the words following each word, then lay them out together. */
+	for (i = 0; i < n; i++)
+		if (id[i] != -1)
+			++words->first[id[i] + 1];
+	for (w = 0; w < words->words; w++) {
+		words->first[w + 1] += words->first[w];
+		fill[w] = words->first[w];
 	}
+	for (i = 0; i < n; i++)
+		if (id[i] != -1)
+			words->next[fill[id[i]]++] = id[i + 1];
 
-	free(line);
-	fclose(f);
+	free(table);
+	free(id);
+	free(fill);
+	return 0;
+}
 
-	if (table->columns == 0) {
-		fprintf(stderr, "ERROR: no columns defined\n");
-		return 3;
+/*
+ * Set up checkpoints for a data file.  When resuming, check the checkpoint
+ * is for the same data, down to the hash of the table definition and the
+ * files it reads, and truncate the data file to the rows it records.  Returns
+ * -1 if the data file is already complete.
+ */
+int resume_data(struct checkpoint_t *checkpoint, pcg64f_random_t *rng,
+		struct table_definition_t *table, struct options_t *options,
+		int resume, int fd, long long first_row, long long last_row)
+{
+	pcg64f_random_t state = *rng;
+	struct stat st;
+
+	checkpoint->fd = fd;
+	checkpoint->interval = options->checkpoint >= 0 ?
+			options->checkpoint : DEFAULT_CHECKPOINT_SECONDS;
+	checkpoint->written = time(NULL);
+	checkpoint->rng = *rng;
+	checkpoint->multiplier = prng_multiplier(table);
+	if (checkpoint->multiplier < 0)
+		return 1;
+
+	if (!resume) {
+		checkpoint->seed = table->seed;
+		checkpoint->version = options->version;
+		checkpoint->format = options->format;
+		checkpoint->compress = options->compress;
+		checkpoint->definition = table->hash;
+		checkpoint->first_row = first_row;
+		checkpoint->last_row = last_row;
+		checkpoint->row = first_row;
+		return 0;
 	}
 
-	if (table->columns > MAX_COLS) {
-		fprintf(stderr, "ERROR: more than %d columns defined\n", MAX_COLS);
-		return 3;
+	pcg64f_advance_r(&state, checkpoint->row * checkpoint->multiplier);
+	if (checkpoint->version != options->version ||
+			checkpoint->format != options->format ||
+			checkpoint->compress != options->compress ||
+			checkpoint->definition != table->hash ||
+			checkpoint->first_row != first_row ||
+			checkpoint->last_row != last_row ||
+			checkpoint->row < first_row || checkpoint->row > last_row ||
+			checkpoint->state != state.state) {
+		fprintf(stderr, "ERROR: checkpoint is for different data: %s\n",
+				checkpoint->filename);
+		return 1;
+	}
+	if (checkpoint->row == last_row) {
+		fprintf(stderr, "datafile is already complete\n");
+		return -1;
 	}
 
-	fprintf(stderr, "%d column(s)\n", *column);
+	if (fstat(fd, &st) == -1 || st.st_size < checkpoint->bytes) {
+		fprintf(stderr, "ERROR: datafile is shorter than its checkpoint\n");
+		return 1;
+	}
+	if (ftruncate(fd, checkpoint->bytes) == -1 ||
+			lseek(fd, checkpoint->bytes, SEEK_SET) == -1) {
+		fprintf(stderr, "ERROR: cannot truncate datafile to %lld bytes "
+				"[%d]\n", checkpoint->bytes, errno);
+		return 1;
+	}
+	checkpoint->resume = 1;
+	fprintf(stderr, "resuming from row %lld\n", checkpoint->row + 1);
 
 	return 0;
 }
 
-int read_list(struct list_t *list)
+/*
+ * Generate the data for one data definition file, returning the exit code
+ * for main().
+ */
+int generate_file(struct options_t *options, char *data_definition_file)
 {
-	FILE *f;
-	size_t len = 0;
-	ssize_t nread;
+	pcg64f_random_t rng;
+	struct table_definition_t table;
+	struct database_t database;
+	struct database_t *load = NULL;
+	struct checkpoint_t checkpoint;
+	struct checkpoint_t *recover = NULL;
+	struct progress_t progress;
+	struct progress_t *report = NULL;
+	unsigned long long seed = options->seed;
+	int resume = 0;
+	char datafile[FILENAME_MAX] = "";
+	char tmp[FILENAME_MAX];
+	char table_name[FILENAME_MAX];
+	char *p;
+	int c;
 
-	f = fopen(list->filename, "r");
-	if (f == NULL) {
-		fprintf(stderr, "ERROR: cannot open list file: %s\n", list->filename);
-		return 1;
+	int fd = STDOUT_FILENO;
+	long long chunk_size;
+	long long first_row = options->first_row;
+	long long last_row = options->last_row;
+
+	memset(&table, 0, sizeof(struct table_definition_t));
+
+	/* Naively remove any extension to the data definition file. */
+	strncpy(tmp, data_definition_file, FILENAME_MAX - 1);
+	tmp[FILENAME_MAX - 1] = '\0';
+	strncpy(table_name, basename(tmp), FILENAME_MAX - 1);
+	table_name[FILENAME_MAX - 1] = '\0';
+	p = strstr(table_name, ".");
+	if (p != NULL)
+		*p = '\0';
+
+	if (options->outdir[0] != '\0') {
+		strcpy(tmp, table_name);
+
+		/* Make sure the new filename doesn't exceed FILENAME_MAX. */
+		c = FILENAME_MAX - (strlen(options->outdir) + strlen(tmp) +
+				strlen(options->suffix) + 7);
+		if (options->chunks > 1) {
+			--c;
+			sprintf(datafile, "%d", options->chunks);
+			c -= strlen(datafile);
+		}
+		if (c < 0) {
+			fprintf(stderr, "ERROR: resulting datafile path and name is too "
+					"long: %s/%s.data%s\n", options->outdir, tmp,
+					options->suffix);
+			return 6;
+		}
+
+		strcpy(datafile, options->outdir);
+		strcat(datafile, "/");
+		strcat(datafile, tmp);
+		if (options->chunks > 1) {
+			sprintf(tmp, "%d", options->chunk);
+			strcat(datafile, ".");
+			strcat(datafile, tmp);
+		}
+		strcat(datafile, ".data");
+		strcat(datafile, options->suffix);
+
+		if (options->checkpoint >= 0 || options->resume) {
+			memset(&checkpoint, 0, sizeof(struct checkpoint_t));
+			sprintf(checkpoint.filename, "%s.checkpoint", datafile);
+			recover = &checkpoint;
+		}
+		if (options->resume) {
+			c = checkpoint_read(&checkpoint);
+			if (c > 0)
+				return 18;
+			resume = c == 0;
+			/* Finish the data with the seed it was started with. */
+			if (resume)
+				seed = checkpoint.seed;
+		}
+
+		/* Mapping a file for writing needs it open for reading too. */
+		fd = open(datafile, (options->io == IO_MMAP ? O_RDWR : O_WRONLY) |
+				O_CREAT | (resume ? 0 : O_TRUNC), 0644);
+		if (fd == -1) {
+			fprintf(stderr, "ERROR: cannot open datafile [%d]: %s\n",
+					errno, datafile);
+			return 7;
+		}
+
+		fprintf(stderr, "datafile: %s\n", datafile);
 	}
 
-#ifdef ENABLE_CASSERT
-	fprintf(stderr, "reading list file: %s\n", list->filename);
-#endif /* ENABLE_CASSERT */
+	table.version = options->version;
+	table.seed = seed;
+	/* Key version 3 data by the table name too so tables don't match. */
+	table.key = counter_random(seed, hash_name(table_name));
 
-	list->size = 0;
-	while ((nread = getline(&list->line[list->size], &len, f)) != -1) {
-		list->line[list->size][nread - 1] = '\0';
-#ifdef ENABLE_CASSERT
-		fprintf(stderr, "%s\n", list->line[list->size]);
-#endif /* ENABLE_CASSERT */
-		++list->size;
-		len = 0;
+	if (options->conninfo != NULL) {
+		database.conninfo = options->conninfo;
+		load = &database;
+		/* The table is named after the data definition file. */
+		if (options->format == FORMAT_PGBINARY)
+			sprintf(database.command, "COPY %s FROM STDIN (FORMAT binary)",
+					table_name);
+		else
+			sprintf(database.command,
+					"COPY %s FROM STDIN (DELIMITER E'\\x%02x')",
+					table_name, (unsigned char) options->delimiter);
 	}
-	fclose(f);
+
+	c = read_data_definition_file(&table, data_definition_file);
+	if (c != 0)
+		return 4;
+
+	if (first_row > 0) {
+		if (last_row > table.rows) {
+			fprintf(stderr, "ERROR: row range ends after row %lld\n",
+					table.rows);
+			return 12;
+		}
+		--first_row;
+	} else if (options->chunks > 1) {
+		chunk_size = table.rows / (long long) options->chunks;
+		first_row = (options->chunk - 1) * chunk_size;
+		last_row = options->chunk * chunk_size;
+	} else
+		last_row = table.rows;
+
+	pcg64f_srandom_r(&rng, seed);
+	if (recover != NULL) {
+		c = resume_data(&checkpoint, &rng, &table, options, resume, fd,
+				first_row, last_row);
+		if (c != 0) {
+			close(fd);
+			return c == -1 ? 0 : 18;
+		}
+		first_row = checkpoint.row;
+	}
+	if (options->progress || options->stats != NULL) {
+		memset(&progress, 0, sizeof(struct progress_t));
+		progress.table = table_name;
+		progress.interval = options->interval;
+		progress.print = options->progress;
+		progress.stats = options->stats;
+		progress.rows = last_row - first_row;
+		report = &progress;
+	}
+	c = generate_data(&rng, options->format, fd,
+			(size_t) options->flush_kb * 1024, options->compress,
+			options->level, load, options->io, &table, options->delimiter,
+			first_row, last_row, options->threads, recover, report);
+	if (options->outdir[0] != '\0') {
+		close(fd);
+	}
+	if (c != 0)
+		return 5;
 
 	return 0;
 }
 
-void sequence(char *result, long long value)
+/*
+ * Generate the data for each data definition file listed in a schema file,
+ * one per line.  Relative names are relative to the schema file.
+ */
+int generate_schema(struct options_t *options, char *schema_file)
 {
-	int rc;
+	FILE *f;
+	char *line = NULL;
+	size_t len = 0;
+	ssize_t nread;
+	char dir[FILENAME_MAX];
+	char filename[FILENAME_MAX];
+	int rc = 0;
+	int c;
 
-	rc = snprintf(result, MAX_BUFFER_LEN - 1, "%lld", value);
-#ifdef ENABLE_CASSERT
-	if (rc < 0 || rc == MAX_BUFFER_LEN - 1)
-		fprintf(stderr, "WARNING: sequence issue converting %lld to string\n",
-				value);
-#endif /* ENABLE_CASSERT */
+	f = fopen(schema_file, "r");
+	if (f == NULL) {
+		fprintf(stderr, "ERROR: cannot open schema file [%d]: %s\n", errno,
+				schema_file);
+		return 17;
+	}
+	strncpy(filename, schema_file, FILENAME_MAX - 1);
+	filename[FILENAME_MAX - 1] = '\0';
+	strcpy(dir, dirname(filename));
+
+	while (rc == 0 && (nread = getline(&line, &len, f)) != -1) {
+		if (nread > 0 && line[nread - 1] == '\n')
+			line[--nread] = '\0';
+		if (nread == 0 || line[0] == '#')
+			continue;
+
+		if (line[0] == '/')
+			c = snprintf(filename, FILENAME_MAX, "%s", line);
+		else
+			c = snprintf(filename, FILENAME_MAX, "%s/%s", dir, line);
+		if (c < 0 || c >= FILENAME_MAX) {
+			fprintf(stderr, "ERROR: schema entry path is too long: %s\n",
+					line);
+			rc = 17;
+			break;
+		}
+		rc = generate_file(options, filename);
+	}
+
+	free(line);
+	fclose(f);
+	return rc;
 }
 
 int main(int argc, char *argv[])
 {
 	int c;
-	unsigned long long seed = -1;
-	pcg64f_random_t rng;
-	struct table_definition_t table;
-	char datafile[FILENAME_MAX] = "";
-
-	char tmp[FILENAME_MAX];
+	struct options_t options;
 	char *p;
 
-	FILE *stream = stdout;
-	int chunk = 0;
-	int chunks = 0;
-	char delimiter = '\t';
 	char data_definition_file[FILENAME_MAX] = "";
-	char outdir[FILENAME_MAX] = "";
+	char schema_file[FILENAME_MAX] = "";
+	char *stats_file = NULL;
 
-	memset(&table, 0, sizeof(struct table_definition_t));
+	memset(&options, 0, sizeof(struct options_t));
+	options.seed = -1;
+	options.flush_kb = DEFAULT_FLUSH_KB;
+	options.format = FORMAT_TEXT;
+	options.compress = COMPRESS_NONE;
+	options.suffix = "";
+	options.io = IO_WRITE;
+	options.threads = 1;
+	options.version = DATA_VERSION_1;
+	options.delimiter = '\t';
+	options.checkpoint = -1;
+	options.interval = DEFAULT_PROGRESS_SECONDS;
 
 	if (argc == 1) {
 		usage(argv[0]);
@@ -537,10 +4817,21 @@ int main(int argc, char *argv[])
 	while (1) {
 		int option_index = 1;
 		static struct option long_options[] = {
+			{"checkpoint", required_argument, 0, 'k'},
+			{"compress", required_argument, 0, 'z'},
+			{"dbconn", required_argument, 0, 'D'},
+			{"format", required_argument, 0, 'F'},
+			{"interval", required_argument, 0, 'I'},
+			{"mmap", no_argument, 0, 'M'},
+			{"progress", no_argument, 0, 'P'},
+			{"resume", no_argument, 0, 'R'},
+			{"schema", required_argument, 0, 'S'},
+			{"stats", required_argument, 0, 'T'},
+			{"uring", optional_argument, 0, 'U'},
 			{0, 0, 0, 0,}
 		};
 
-		c = getopt_long(argc, argv, "c:C:d:f:ho:s:",
+		c = getopt_long(argc, argv, "b:c:C:d:D:f:F:hI:j:k:Mo:Pr:Rs:S:T:U::V:z:",
 				long_options, &option_index);
 		if (c == -1)
 			break;
@@ -548,26 +4839,131 @@ int main(int argc, char *argv[])
 		switch (c) {
 		case 0:
 			break;
+		case 'b':
+			options.flush_kb = atol(optarg);
+			break;
 		case 'c':
-			chunks = atoi(optarg);
+			options.chunks = atoi(optarg);
 			break;
 		case 'C':
-			chunk = atoi(optarg);
+			options.chunk = atoi(optarg);
 			break;
 		case 'd':
-			delimiter = optarg[0];
+			options.delimiter = optarg[0];
+			break;
+		case 'D':
+			options.conninfo = optarg;
 			break;
 		case 'f':
 			strncpy(data_definition_file, optarg, FILENAME_MAX - 1);
 			break;
+		case 'F':
+			if (strcmp(optarg, "text") == 0)
+				options.format = FORMAT_TEXT;
+			else if (strcmp(optarg, "pgbinary") == 0)
+				options.format = FORMAT_PGBINARY;
+			else if (strcmp(optarg, "columnar") == 0)
+				options.format = FORMAT_COLUMNAR;
+			else {
+				fprintf(stderr, "ERROR: unknown output format: %s\n", optarg);
+				return 13;
+			}
+			break;
 		case 'h':
 			usage(argv[0]);
 			return 0;
+		case 'I':
+			options.interval = atoi(optarg);
+			if (options.interval < 1) {
+				fprintf(stderr, "ERROR: progress interval must be at "
+						"least 1 second\n");
+				return 19;
+			}
+			break;
+		case 'j':
+			options.threads = atoi(optarg);
+			break;
+		case 'k':
+			options.checkpoint = atoi(optarg);
+			if (options.checkpoint < 0) {
+				fprintf(stderr, "ERROR: checkpoint interval cannot be "
+						"negative\n");
+				return 18;
+			}
+			break;
+		case 'M':
+			options.io = IO_MMAP;
+			break;
 		case 'o':
-			strncpy(outdir, optarg, FILENAME_MAX - 1);
+			strncpy(options.outdir, optarg, FILENAME_MAX - 1);
+			break;
+		case 'P':
+			options.progress = 1;
+			break;
+		case 'r':
+			if (sscanf(optarg, "%lld,%lld", &options.first_row,
+					&options.last_row) != 2 || options.first_row < 1 ||
+					options.last_row < options.first_row) {
+				fprintf(stderr, "ERROR: invalid row range: %s\n", optarg);
+				return 12;
+			}
+			break;
+		case 'R':
+			options.resume = 1;
 			break;
 		case 's':
-			seed = atoll(optarg);
+			options.seed = atoll(optarg);
+			break;
+		case 'S':
+			strncpy(schema_file, optarg, FILENAME_MAX - 1);
+			break;
+		case 'T':
+			stats_file = optarg;
+			break;
+		case 'U':
+			if (optarg == NULL)
+				options.io = IO_URING;
+			else if (strcmp(optarg, "direct") == 0)
+				options.io = IO_URING_DIRECT;
+			else {
+				fprintf(stderr, "ERROR: unknown io_uring option: %s\n",
+						optarg);
+				return 16;
+			}
+			break;
+		case 'V':
+			options.version = atoi(optarg);
+			break;
+		case 'z':
+			p = strchr(optarg, ':');
+			if (strncmp(optarg, "gzip", 4) == 0 &&
+					(optarg[4] == '\0' || p == optarg + 4)) {
+				options.compress = COMPRESS_GZIP;
+				options.level = DEFAULT_GZIP_LEVEL;
+				options.suffix = ".gz";
+			} else if (strncmp(optarg, "zstd", 4) == 0 &&
+					(optarg[4] == '\0' || p == optarg + 4)) {
+#ifdef HAVE_ZSTD
+				options.compress = COMPRESS_ZSTD;
+				options.level = DEFAULT_ZSTD_LEVEL;
+				options.suffix = ".zst";
+#else
+				fprintf(stderr, "ERROR: built without zstd support\n");
+				return 14;
+#endif /* HAVE_ZSTD */
+			} else {
+				fprintf(stderr, "ERROR: unknown compression: %s\n", optarg);
+				return 14;
+			}
+			if (p != NULL) {
+				options.level = atoi(p + 1);
+				if (options.level < 1 || options.level >
+						(options.compress == COMPRESS_GZIP ? 9 : 22)) {
+					fprintf(stderr, "ERROR: invalid compression level: %s\n",
+							optarg);
+					return 14;
+				}
+			}
 			break;
 		default:
 			printf("?? getopt returned character code 0%o ??\n", c);
@@ -575,74 +4971,101 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	if (data_definition_file[0] == '\0') {
+	if (data_definition_file[0] == '\0' && schema_file[0] == '\0') {
 		fprintf(stderr, "ERROR: use -f to specify data definition file\n");
 		return 3;
 	}
 
-    /* For ease of testing, work with everything in GMT/UTC. */
-    putenv("TZ=\":GMT\"");
+	if (options.chunks > 1 && options.chunk < 1) {
+		fprintf(stderr, "ERROR: must specify which chunk to create with -C\n");
+		return 8;
+	}
 
-	if (seed == -1) {
-		entropy_getbytes((void*) seed, sizeof(seed));
+	if (options.threads < 1) {
+		fprintf(stderr, "ERROR: number of threads must be at least 1\n");
+		return 9;
 	}
-	fprintf(stderr, "seed: %llu\n", seed);
 
-	if (outdir[0] != '\0') {
-		/* Naively remove any extension to the data definition file. */
-		strncpy(tmp, basename(data_definition_file), FILENAME_MAX - 1);
-		p = strstr(tmp, ".");
-		*p = '\0';
+	if (options.flush_kb < 1) {
+		fprintf(stderr, "ERROR: buffer size must be at least 1 kilobyte\n");
+		return 10;
+	}
 
-		/* Make sure the new filename doesn't exceed FILENAME_MAX. */
-		c = FILENAME_MAX - (strlen(outdir) + strlen(tmp) + 7);
-		if (chunks > 1) {
-			--c;
-			sprintf(datafile, "%d", chunks);
-			c -= strlen(datafile);
-		}
-		if (c < 0) {
-			fprintf(stderr, "ERROR: resulting datafile path and name is too "
-					"long: %s/%s.data\n", outdir, tmp);
-			return 6;
-		}
+	if (options.version < DATA_VERSION_1 ||
+			options.version > DATA_VERSION_MAX) {
+		fprintf(stderr, "ERROR: data version must be between %d and %d\n",
+				DATA_VERSION_1, DATA_VERSION_MAX);
+		return 11;
+	}
 
-		strcpy(datafile, outdir);
-		strcat(datafile, "/");
-		strcat(datafile, tmp);
-		if (chunks > 1) {
-			sprintf(tmp, "%d", chunk);
-			strcat(datafile, ".");
-			strcat(datafile, tmp);
-		}
-		strcat(datafile, ".data");
+	if (options.first_row > 0 && options.chunks > 1) {
+		fprintf(stderr, "ERROR: cannot use a row range with chunks\n");
+		return 12;
+	}
 
-		stream = fopen(datafile, "w");
-		if (stream == NULL) {
-			fprintf(stderr, "ERROR: cannot open datafile [%d]: %s\n",
-					errno, datafile);
-			return 7;
-		}
+	if (options.conninfo != NULL && (options.outdir[0] != '\0' ||
+			options.compress != COMPRESS_NONE ||
+			options.format == FORMAT_COLUMNAR)) {
+		fprintf(stderr, "ERROR: cannot load the database with -o, -z or "
+				"columnar format\n");
+		return 15;
+	}
 
-		fprintf(stderr, "datafile: %s\n", datafile);
+	if (options.io == IO_MMAP && (options.outdir[0] == '\0' ||
+			options.compress != COMPRESS_NONE ||
+			options.format == FORMAT_COLUMNAR || options.conninfo != NULL)) {
+		fprintf(stderr, "ERROR: --mmap needs -o and cannot be used with -D, -z "
+				"or columnar format\n");
+		return 16;
+	}
+	if (options.io != IO_WRITE && options.io != IO_MMAP &&
+			(options.outdir[0] == '\0' || options.conninfo != NULL)) {
+		fprintf(stderr, "ERROR: --uring needs -o and cannot be used with "
+				"-D\n");
+		return 16;
 	}
 
-	if (chunks > 1 && chunk < 1) {
-		fprintf(stderr, "ERROR: must specify which chunk to create with -C\n");
-		return 8;
+	if (schema_file[0] != '\0' && (data_definition_file[0] != '\0' ||
+			options.first_row > 0 || options.chunks > 1 ||
+			(options.outdir[0] == '\0' && options.conninfo == NULL))) {
+		fprintf(stderr, "ERROR: a schema needs -o or -D, and cannot be used "
+				"with -f, -r or chunks\n");
+		return 17;
 	}
 
-	c = read_data_definition_file(&table, data_definition_file);
-	if (c != 0)
-		return 4;
+	if ((options.checkpoint >= 0 || options.resume) &&
+			(options.outdir[0] == '\0' || options.io != IO_WRITE ||
+			options.format == FORMAT_COLUMNAR)) {
+		fprintf(stderr, "ERROR: checkpoints need -o, and cannot be used with "
+				"--mmap, --uring or columnar format\n");
+		return 18;
+	}
 
-	pcg64f_srandom_r(&rng, seed);
-	c = generate_data(&rng, stream, &table, delimiter, chunks, chunk);
-	if (c != 0)
-		return 5;
-	if (outdir[0] != '\0') {
-		fclose(stream);
+    /* For ease of testing, work with everything in GMT/UTC. */
+    putenv("TZ=\":GMT\"");
+
+	if (options.seed == -1) {
+		entropy_getbytes((void*) options.seed, sizeof(options.seed));
 	}
+	fprintf(stderr, "seed: %llu\n", options.seed);
 
-	return 0;
+	if (stats_file != NULL) {
+		options.stats = fopen(stats_file, "w");
+		if (options.stats == NULL) {
+			fprintf(stderr, "ERROR: cannot open stats file [%d]: %s\n",
+					errno, stats_file);
+			return 19;
+		}
+		fprintf(options.stats, "table,seconds,thread,rows,bytes,"
+				"rows_per_second,mb_per_second,generate_seconds,"
+				"wait_seconds,write_seconds\n");
+	}
+
+	if (schema_file[0] != '\0')
+		c = generate_schema(&options, schema_file);
+	else
+		c = generate_file(&options, data_definition_file);
+	if (options.stats != NULL)
+		fclose(options.stats);
+	return c;
 }
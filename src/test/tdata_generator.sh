@@ -9,6 +9,18 @@ oneTimeSetUp() {
 	export HOMEDIR=`dirname $0`
 }
 
+testBufferSizeSameOutput() {
+	TABLE="mixed-columns"
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 \
+			> $SHUNIT_TMPDIR/${TABLE}.default
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 -b 1 \
+			> $SHUNIT_TMPDIR/${TABLE}.small
+	ROWS=`wc -l < $SHUNIT_TMPDIR/${TABLE}.small`
+	assertEquals "rows" 50000 $ROWS
+	cmp -s $SHUNIT_TMPDIR/${TABLE}.default $SHUNIT_TMPDIR/${TABLE}.small
+	assertEquals "data generated with small buffer" 0 $?
+}
+
 testCheckRowCount() {
 	TABLE="two-rows"
 	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -o $SHUNIT_TMPDIR
@@ -40,6 +52,15 @@ testChunkNotSpecified() {
 	assertEquals "touchstone-generate-table-data" 8 $?
 }
 
+testDateFormat() {
+	TABLE="mixed-columns"
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 \
+			> $SHUNIT_TMPDIR/${TABLE}.data
+	ROWS=`cut -f 3 $SHUNIT_TMPDIR/${TABLE}.data | \
+			grep -c '^2[01][0-9][0-9]-[01][0-9]-[0-3][0-9]$'`
+	assertEquals "ISO-8601 dates" 50000 $ROWS
+}
+
 testDataFileCreated() {
 	TABLE="two-rows"
 	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -o $SHUNIT_TMPDIR
@@ -91,11 +112,204 @@ testListFileDoesNotExist() {
 	assertEquals "touchstone-generate-table-data" 4 $?
 }
 
+testExpression() {
+	printf "100\nd2020-01-01,2021-01-01\nx\$1 + random(1,30)\ni1,10\n" \
+			> $SHUNIT_TMPDIR/expression.ddf
+	printf 'i1,100\nx$3 * $4\nx$2 - $1\n' >> $SHUNIT_TMPDIR/expression.ddf
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/expression.ddf -s 1 \
+			> $SHUNIT_TMPDIR/expression.data
+	assertEquals "touchstone-generate-table-data" 0 $?
+	WRONG=`awk '$5 != $3 * $4 || $6 < 1 || $6 > 30 || $2 <= $1' \
+			$SHUNIT_TMPDIR/expression.data | wc -l`
+	assertEquals "rows with wrong derived values" 0 $WRONG
+}
+
+testExpressionOverflow() {
+	MIN=-9223372036854775808
+	printf "10\ni$MIN,$MIN\nx\$1 / (0 - 1)\nx\$1 %% (0 - 1)\nx\$1 / 0\n" \
+			> $SHUNIT_TMPDIR/overflow.ddf
+	printf 'x$1 - 1\nx0 - $1\n' >> $SHUNIT_TMPDIR/overflow.ddf
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/overflow.ddf -s 1 \
+			> $SHUNIT_TMPDIR/overflow.data
+	assertEquals "touchstone-generate-table-data" 0 $?
+	ROW=`head -n 1 $SHUNIT_TMPDIR/overflow.data`
+	assertEquals "wrapped values" \
+			"$MIN	$MIN	0	0	9223372036854775807	$MIN" "$ROW"
+}
+
+testFormatColumnar() {
+	TABLE="mixed-columns"
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf \
+			--format=columnar > $SHUNIT_TMPDIR/${TABLE}.data
+	MAGIC=`head -c 8 $SHUNIT_TMPDIR/${TABLE}.data`
+	assertEquals "leading magic" "TSCOLUMN" "$MAGIC"
+	MAGIC=`tail -c 8 $SHUNIT_TMPDIR/${TABLE}.data`
+	assertEquals "trailing magic" "TSCOLUMN" "$MAGIC"
+}
+
+testFormatColumnarThreads() {
+	TABLE="mixed-columns"
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 \
+			--format=columnar > $SHUNIT_TMPDIR/${TABLE}.1
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 \
+			--format=columnar -j 3 > $SHUNIT_TMPDIR/${TABLE}.3
+	cmp -s $SHUNIT_TMPDIR/${TABLE}.1 $SHUNIT_TMPDIR/${TABLE}.3
+	assertEquals "columnar data generated with threads" 0 $?
+}
+
+testFormatPgbinary() {
+	TABLE="two-rows"
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf \
+			--format=pgbinary > $SHUNIT_TMPDIR/${TABLE}.data
+	SIGNATURE=`head -c 6 $SHUNIT_TMPDIR/${TABLE}.data`
+	assertEquals "signature" "PGCOPY" "$SIGNATURE"
+	# Header, 2 rows of a field count and an int8 field, and the trailer.
+	BYTES=`wc -c < $SHUNIT_TMPDIR/${TABLE}.data`
+	assertEquals "bytes" 49 $BYTES
+}
+
+testInvalidBufferSize() {
+	touchstone-generate-table-data -f ${HOMEDIR}/two-rows.ddf -b 0
+	assertEquals "touchstone-generate-table-data" 10 $?
+}
+
+testInvalidVersion() {
+	touchstone-generate-table-data -f ${HOMEDIR}/two-rows.ddf -V 0
+	assertEquals "touchstone-generate-table-data" 11 $?
+}
+
+testCompressGzip() {
+	TABLE="mixed-columns"
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 \
+			> $SHUNIT_TMPDIR/${TABLE}.data
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 -j 3 \
+			--compress=gzip:1 | gzip -dc > $SHUNIT_TMPDIR/${TABLE}.gz.data
+	cmp -s $SHUNIT_TMPDIR/${TABLE}.data $SHUNIT_TMPDIR/${TABLE}.gz.data
+	assertEquals "decompressed data" 0 $?
+}
+
+testHotspotZipfian() {
+	printf "10000\nh1,100,90,10\nz1,100,2\n" > $SHUNIT_TMPDIR/skew.ddf
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/skew.ddf -s 1 \
+			> $SHUNIT_TMPDIR/skew.data
+	HOT=`awk '$1 <= 10' $SHUNIT_TMPDIR/skew.data | wc -l`
+	assertTrue "hot keys" "[ $HOT -gt 8500 -a $HOT -lt 9500 ]"
+	FIRST=`awk '$2 == 1' $SHUNIT_TMPDIR/skew.data | wc -l`
+	assertTrue "most frequent zipfian value" "[ $FIRST -gt 5500 ]"
+}
+
+testResume() {
+	printf "300000\ns1\ni1,1000\nt10,40\n" > $SHUNIT_TMPDIR/resume.ddf
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/resume.ddf -s 1 \
+			> $SHUNIT_TMPDIR/resume.1
+	mkdir -p $SHUNIT_TMPDIR/resume
+	# Stop the first run partway by limiting the file size.
+	(ulimit -f 1000; touchstone-generate-table-data \
+			-f $SHUNIT_TMPDIR/resume.ddf -s 1 -k 0 -b 64 \
+			-o $SHUNIT_TMPDIR/resume)
+	grep -q "^row: 300000$" $SHUNIT_TMPDIR/resume/resume.data.checkpoint
+	assertNotEquals "checkpoint of partial data" 0 $?
+	mv $SHUNIT_TMPDIR/resume.ddf $SHUNIT_TMPDIR/resume.orig
+	printf "300000\ns1\ni1000,2000\nt10,40\n" > $SHUNIT_TMPDIR/resume.ddf
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/resume.ddf -R \
+			-o $SHUNIT_TMPDIR/resume 2> /dev/null
+	assertEquals "resume with a changed definition" 18 $?
+	mv $SHUNIT_TMPDIR/resume.orig $SHUNIT_TMPDIR/resume.ddf
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/resume.ddf -j 2 -R \
+			-o $SHUNIT_TMPDIR/resume
+	assertEquals "resume" 0 $?
+	cmp -s $SHUNIT_TMPDIR/resume.1 $SHUNIT_TMPDIR/resume/resume.data
+	assertEquals "resumed data matches" 0 $?
+	grep -q "^row: 300000$" $SHUNIT_TMPDIR/resume/resume.data.checkpoint
+	assertEquals "checkpoint of complete data" 0 $?
+}
+
+testProgressStats() {
+	TABLE="mixed-columns"
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 -j 2 -P \
+			-T $SHUNIT_TMPDIR/stats.csv > /dev/null 2> $SHUNIT_TMPDIR/progress
+	grep -q "^${TABLE}: 50000 of 50000 rows" $SHUNIT_TMPDIR/progress
+	assertEquals "final progress line" 0 $?
+	ROWS=`tail -n 1 $SHUNIT_TMPDIR/stats.csv | cut -d , -f 3,4`
+	assertEquals "rows of all threads" "all,50000" "$ROWS"
+	THREADS=`tail -n 3 $SHUNIT_TMPDIR/stats.csv | cut -d , -f 3 | \
+			tr '\n' ' '`
+	assertEquals "lines for each thread" "0 1 all " "$THREADS"
+}
+
+testReferenceSchema() {
+	printf "100\ns1\ni1,1000\n" > $SHUNIT_TMPDIR/customers.ddf
+	printf "1000\ns1\nrcustomers.1\nrcustomers.2\n" \
+			> $SHUNIT_TMPDIR/orders.ddf
+	printf "customers.ddf\norders.ddf\n" > $SHUNIT_TMPDIR/schema
+	touchstone-generate-table-data -S $SHUNIT_TMPDIR/schema -s 1 -V 3 \
+			-o $SHUNIT_TMPDIR
+	assertEquals "touchstone-generate-table-data" 0 $?
+	MISSING=`awk 'NR == FNR { id[$1] = 1; value[$2] = 1; next }
+			!($2 in id) || !($3 in value)' $SHUNIT_TMPDIR/customers.data \
+			$SHUNIT_TMPDIR/orders.data | wc -l`
+	assertEquals "references to missing rows" 0 $MISSING
+}
+
+testInvalidCompression() {
+	touchstone-generate-table-data -f ${HOMEDIR}/two-rows.ddf -z lzma
+	assertEquals "touchstone-generate-table-data" 14 $?
+}
+
+testInvalidDbconn() {
+	touchstone-generate-table-data -f ${HOMEDIR}/two-rows.ddf -z gzip \
+			--dbconn="dbname=touchstone"
+	assertEquals "touchstone-generate-table-data" 15 $?
+}
+
+testInvalidFormat() {
+	touchstone-generate-table-data -f ${HOMEDIR}/two-rows.ddf --format=csv
+	assertEquals "touchstone-generate-table-data" 13 $?
+}
+
+testInvalidThreads() {
+	touchstone-generate-table-data -f ${HOMEDIR}/two-rows.ddf -j 0
+	assertEquals "touchstone-generate-table-data" 9 $?
+}
+
 testMissingDataDefinitionFile() {
 	touchstone-generate-table-data -f ${HOMEDIR}/doesnotexist
 	assertEquals "touchstone-generate-table-data" 4 $?
 }
 
+testNullDistinct() {
+	printf "10000\ni1,1000000;distinct=10\ni1,10;null=20\n" \
+			> $SHUNIT_TMPDIR/null.ddf
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/null.ddf -s 1 \
+			> $SHUNIT_TMPDIR/null.data
+	DISTINCT=`cut -f 1 $SHUNIT_TMPDIR/null.data | sort -u | wc -l`
+	assertEquals "distinct values" 10 $DISTINCT
+	NULLS=`cut -f 2 $SHUNIT_TMPDIR/null.data | grep -c '^\\\\N$'`
+	assertTrue "NULL fraction" "[ $NULLS -gt 1800 -a $NULLS -lt 2200 ]"
+}
+
+testNumeric() {
+	printf "1000\ni-99999,99999;numeric=7,2\ni1,5000;numeric=2,0\n" \
+			> $SHUNIT_TMPDIR/numeric.ddf
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/numeric.ddf -s 1 \
+			> $SHUNIT_TMPDIR/numeric.data 2> /dev/null
+	assertNotEquals "range wider than the precision" 0 $?
+	for COLUMN in "i1,2;numeric=19,0" "s1;numeric=3,0" \
+			"z1,2000000000000000000,1.0;numeric=3,0" "p5;numeric=3,0" \
+			'x$1;numeric=3,0'; do
+		printf "1000\ni1,2\n%s\n" "$COLUMN" > $SHUNIT_TMPDIR/numeric.ddf
+		touchstone-generate-table-data -f $SHUNIT_TMPDIR/numeric.ddf \
+				> /dev/null 2>&1
+		assertNotEquals "numeric range not checked: $COLUMN" 0 $?
+	done
+	printf "1000\ni-99999,99999;numeric=7,2\n" > $SHUNIT_TMPDIR/numeric.ddf
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/numeric.ddf -s 1 \
+			> $SHUNIT_TMPDIR/numeric.data
+	WRONG=`grep -c -v '^-\{0,1\}[0-9]\{1,3\}\.[0-9][0-9]$' \
+			$SHUNIT_TMPDIR/numeric.data`
+	assertEquals "numerics with 2 decimal places" 0 $WRONG
+}
+
 testNoColumns() {
 	touchstone-generate-table-data -f ${HOMEDIR}/no-columns.ddf
 	assertEquals "touchstone-generate-table-data" 4 $?
@@ -106,6 +320,156 @@ testNoCommandLineArguments() {
 	assertEquals "touchstone-generate-table-data" 1 $?
 }
 
+testThreadsChunk() {
+	TABLE="mixed-columns"
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 -c 3 -C 2 \
+			> $SHUNIT_TMPDIR/${TABLE}.1
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 -c 3 -C 2 \
+			-j 4 > $SHUNIT_TMPDIR/${TABLE}.4
+	ROWS=`wc -l < $SHUNIT_TMPDIR/${TABLE}.4`
+	assertEquals "rows" 16666 $ROWS
+	cmp -s $SHUNIT_TMPDIR/${TABLE}.1 $SHUNIT_TMPDIR/${TABLE}.4
+	assertEquals "chunk generated with threads" 0 $?
+}
+
+testLongList() {
+	seq 1 1000 > $SHUNIT_TMPDIR/numbers.txt
+	printf "10000\nl$SHUNIT_TMPDIR/numbers.txt\n" > $SHUNIT_TMPDIR/long-list.ddf
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/long-list.ddf -s 1 \
+			> $SHUNIT_TMPDIR/long-list.data
+	VALUES=`sort -u $SHUNIT_TMPDIR/long-list.data | wc -l`
+	assertTrue "more than 16 values selected" "[ $VALUES -gt 16 ]"
+}
+
+testWeightedList() {
+	printf "3,often\n0,never\n1,seldom\n" > $SHUNIT_TMPDIR/weights.txt
+	printf "10000\nw$SHUNIT_TMPDIR/weights.txt\n" > $SHUNIT_TMPDIR/weighted.ddf
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/weighted.ddf -s 1 \
+			> $SHUNIT_TMPDIR/weighted.data
+	NEVER=`grep -c never $SHUNIT_TMPDIR/weighted.data`
+	assertEquals "lines with no weight" 0 $NEVER
+	OFTEN=`grep -c often $SHUNIT_TMPDIR/weighted.data`
+	assertTrue "heavier lines picked more" "[ $OFTEN -gt 7000 ]"
+}
+
+testWords() {
+	printf "a b\nc d\n" > $SHUNIT_TMPDIR/words.txt
+	printf "10000\nm$SHUNIT_TMPDIR/words.txt,5,20\n" \
+			> $SHUNIT_TMPDIR/words.ddf
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/words.ddf -s 1 \
+			> $SHUNIT_TMPDIR/words.data
+	LENGTH=`awk 'length < 5 || length > 20' $SHUNIT_TMPDIR/words.data | wc -l`
+	assertEquals "text length out of range" 0 $LENGTH
+	SPACES=`grep -c ' $' $SHUNIT_TMPDIR/words.data`
+	assertEquals "text ending with a space" 0 $SPACES
+	# Only a word that ends a line can be followed by the start of one.
+	PAIRS=`grep -c -E 'a [acd]|b [bd]|c [abc]|d [bd]' \
+			$SHUNIT_TMPDIR/words.data`
+	assertEquals "words that never follow each other" 0 $PAIRS
+}
+
+testMmapSameOutput() {
+	TABLE="mixed-columns"
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 \
+			> $SHUNIT_TMPDIR/${TABLE}.1
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 -j 4 \
+			--mmap -o $SHUNIT_TMPDIR
+	cmp -s $SHUNIT_TMPDIR/${TABLE}.1 $SHUNIT_TMPDIR/${TABLE}.data
+	assertEquals "data copied into a mapped file" 0 $?
+}
+
+testThreadsSameOutput() {
+	TABLE="mixed-columns"
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 \
+			> $SHUNIT_TMPDIR/${TABLE}.1
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 -j 4 \
+			> $SHUNIT_TMPDIR/${TABLE}.4
+	ROWS=`wc -l < $SHUNIT_TMPDIR/${TABLE}.4`
+	assertEquals "rows" 50000 $ROWS
+	cmp -s $SHUNIT_TMPDIR/${TABLE}.1 $SHUNIT_TMPDIR/${TABLE}.4
+	assertEquals "data generated with threads" 0 $?
+}
+
+testTimestamp() {
+	printf "1000\nT2020-01-01,2020-01-02\nZ2020-01-01 12:00:00,%s\n" \
+			"2020-01-01 12:00:01" > $SHUNIT_TMPDIR/timestamp.ddf
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/timestamp.ddf -s 1 \
+			> $SHUNIT_TMPDIR/timestamp.data
+	DAY='2020-01-01T[0-9:]*\.[0-9]\{6\}'
+	SECOND='2020-01-01T12:00:00\.[0-9]\{6\}Z'
+	WRONG=`grep -c -v "^$DAY	$SECOND$" $SHUNIT_TMPDIR/timestamp.data`
+	assertEquals "timestamps out of range" 0 $WRONG
+}
+
+testUnique() {
+	printf "10000\nu1,10000\n" > $SHUNIT_TMPDIR/unique.ddf
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/unique.ddf -s 1 \
+			> $SHUNIT_TMPDIR/unique.data
+	COUNT=`sort -u $SHUNIT_TMPDIR/unique.data | wc -l`
+	assertEquals "unique values" 10000 $COUNT
+	assertNotEquals "values are in a random order" 1 \
+			`head -n 1 $SHUNIT_TMPDIR/unique.data`
+	touchstone-generate-table-data -f $SHUNIT_TMPDIR/unique.ddf -s 1 \
+			-c 2 -C 2 > $SHUNIT_TMPDIR/unique.2.data
+	tail -n 5000 $SHUNIT_TMPDIR/unique.data | \
+			cmp -s - $SHUNIT_TMPDIR/unique.2.data
+	assertEquals "chunk matches the same rows" 0 $?
+}
+
+testUringSameOutput() {
+	TABLE="mixed-columns"
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 \
+			> $SHUNIT_TMPDIR/${TABLE}.1
+	# Falls back to write() if io_uring is not available.
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 -j 2 -b 1 \
+			--uring -o $SHUNIT_TMPDIR
+	cmp -s $SHUNIT_TMPDIR/${TABLE}.1 $SHUNIT_TMPDIR/${TABLE}.data
+	assertEquals "data written with io_uring" 0 $?
+}
+
+testVersion3Threads() {
+	TABLE="mixed-columns"
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 -V 3 \
+			> $SHUNIT_TMPDIR/${TABLE}.1
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 -V 3 -j 4 \
+			> $SHUNIT_TMPDIR/${TABLE}.4
+	ROWS=`wc -l < $SHUNIT_TMPDIR/${TABLE}.4`
+	assertEquals "rows" 50000 $ROWS
+	cmp -s $SHUNIT_TMPDIR/${TABLE}.1 $SHUNIT_TMPDIR/${TABLE}.4
+	assertEquals "version 3 data generated with threads" 0 $?
+}
+
+testVersion2Threads() {
+	TABLE="mixed-columns"
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 -V 2 \
+			> $SHUNIT_TMPDIR/${TABLE}.1
+	touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 -V 2 -j 4 \
+			> $SHUNIT_TMPDIR/${TABLE}.4
+	ROWS=`wc -l < $SHUNIT_TMPDIR/${TABLE}.4`
+	assertEquals "rows" 50000 $ROWS
+	cmp -s $SHUNIT_TMPDIR/${TABLE}.1 $SHUNIT_TMPDIR/${TABLE}.4
+	assertEquals "version 2 data generated with threads" 0 $?
+}
+
+testRowRange() {
+	TABLE="mixed-columns"
+	for VERSION in 1 3; do
+		touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 \
+				-V $VERSION | sed -n "20001,30000p" > $SHUNIT_TMPDIR/${TABLE}.all
+		touchstone-generate-table-data -f ${HOMEDIR}/${TABLE}.ddf -s 1 \
+				-V $VERSION -r 20001,30000 > $SHUNIT_TMPDIR/${TABLE}.range
+		ROWS=`wc -l < $SHUNIT_TMPDIR/${TABLE}.range`
+		assertEquals "rows" 10000 $ROWS
+		cmp -s $SHUNIT_TMPDIR/${TABLE}.all $SHUNIT_TMPDIR/${TABLE}.range
+		assertEquals "version $VERSION row range" 0 $?
+	done
+}
+
+testRowRangeInvalid() {
+	touchstone-generate-table-data -f ${HOMEDIR}/two-rows.ddf -r 1,3
+	assertEquals "touchstone-generate-table-data" 12 $?
+}
+
 testTooManyColumnsDefined() {
 	touchstone-generate-table-data -f ${HOMEDIR}/too-many-columns.ddf
 	assertEquals "touchstone-generate-table-data" 4 $?
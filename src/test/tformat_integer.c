@@ -0,0 +1,91 @@
+/*
+ * Copyright 2019 PostgreSQL Global Development Group
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+
+#include "touchstone.h"
+
+/*
+ * Compare format_integer() against printf() around every power of 10, and
+ * format_timestamp() against gmtime_r().
+ */
+int main()
+{
+	char expected[MAX_TIMESTAMP_LEN + 1];
+	char str[MAX_INTEGER_LEN + 1];
+	char timestamp[MAX_TIMESTAMP_LEN + 1];
+	char numeric[MAX_NUMERIC_LEN + 1];
+	struct tm tm;
+	time_t t;
+	long long power;
+	long long value;
+	int length;
+	int i;
+	int rc = 0;
+	long long values[] = {LLONG_MIN, LLONG_MAX};
+	long long numerics[] = {12345, -5, 0, 100, LLONG_MIN};
+	const char *formatted[] = {"123.45", "-0.05", "0.00", "1.00",
+			"-92233720368547758.08"};
+
+	for (power = 1; power > 0 && power <= LLONG_MAX / 10; power *= 10) {
+		for (value = power - 2; value <= power + 1; value++) {
+			for (i = -1; i <= 1; i += 2) {
+				length = format_integer(str, value * i);
+				str[length] = '\0';
+				snprintf(expected, sizeof(expected), "%lld", value * i);
+				if (strcmp(str, expected) != 0) {
+					printf("expected %s got %s\n", expected, str);
+					rc = 1;
+				}
+			}
+		}
+	}
+
+	for (i = 0; i < 2; i++) {
+		length = format_integer(str, values[i]);
+		str[length] = '\0';
+		snprintf(expected, sizeof(expected), "%lld", values[i]);
+		if (strcmp(str, expected) != 0) {
+			printf("expected %s got %s\n", expected, str);
+			rc = 1;
+		}
+	}
+
+	length = format_date(str, 2001, 2, 3);
+	str[length] = '\0';
+	if (strcmp(str, "2001-02-03") != 0) {
+		printf("expected 2001-02-03 got %s\n", str);
+		rc = 1;
+	}
+
+	/* Compare format_timestamp() against gmtime_r() either side of 1970. */
+	for (value = -5000000000000000LL; value < 5000000000000000LL;
+			value += 123456789012345LL) {
+		t = (time_t) (value / 1000000 - (value % 1000000 < 0));
+		gmtime_r(&t, &tm);
+		strftime(expected, sizeof(expected), "%Y-%m-%dT%H:%M:%S", &tm);
+		snprintf(expected + 19, sizeof(expected) - 19, ".%06lldZ",
+				(value % 1000000 + 1000000) % 1000000);
+		length = format_timestamp(timestamp, value, 1);
+		timestamp[length] = '\0';
+		if (strcmp(timestamp, expected) != 0) {
+			printf("expected %s got %s\n", expected, timestamp);
+			rc = 1;
+		}
+	}
+
+	for (i = 0; i < 5; i++) {
+		length = format_numeric(numeric, numerics[i], 2);
+		numeric[length] = '\0';
+		if (strcmp(numeric, formatted[i]) != 0) {
+			printf("expected %s got %s\n", formatted[i], numeric);
+			rc = 1;
+		}
+	}
+
+	return rc;
+}
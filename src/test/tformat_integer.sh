@@ -0,0 +1,12 @@
+#! /bin/sh
+#
+# Copyright 2019 PostgreSQL Global Development Group
+#
+
+testFormatInteger() {
+	export LD_LIBRARY_PATH=".."
+	./tformat_integer
+	assertEquals "success" 0 $?
+}
+
+. `which shunit2`
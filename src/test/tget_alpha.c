@@ -3,13 +3,14 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "touchstone.h"
 
-int main()
+int main(int argc, char *argv[])
 {
 	int i;
-	char str[2];
+	char str[ALPHA_PER_RAND * 2 + 2];
 
 	unsigned long long seed = -1;
 	pcg64f_random_t rng;
@@ -17,6 +18,16 @@ int main()
 	entropy_getbytes((void*) seed, sizeof(seed));
 	pcg64f_srandom_r(&rng, seed);
 
+	/* Use "mix" to test the version 2 text generator with longer strings. */
+	if (argc > 1 && strcmp(argv[1], "mix") == 0) {
+		for (i = 0; i < 1000; i ++) {
+			get_alpha_mix(pcg64f_random_r(&rng), str, ALPHA_PER_RAND * 2 + 1,
+					ALPHA_PER_RAND * 2 + 1);
+			printf("%s\n", str);
+		}
+		return 0;
+	}
+
 	for (i = 0; i < 1000; i ++) {
 		get_alpha(&rng, str, 1, 1);
 		printf("%s\n", str);
@@ -11,4 +11,13 @@ testAlpha1()
 	assertEquals "52 letters" 52 $COUNT
 }
 
+testAlphaMix()
+{
+	export LD_LIBRARY_PATH=".."
+	LENGTH=`./tget_alpha mix | awk '{ print length($0) }' | sort -u`
+	assertEquals "string length" 17 $LENGTH
+	COUNT=`./tget_alpha mix | fold -w 1 | sort | uniq | wc -l`
+	assertEquals "52 letters" 52 $COUNT
+}
+
 . `which shunit2`
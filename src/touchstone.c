@@ -10,6 +10,84 @@
 
 const char *alpha = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
 
+/* Two ASCII digits for every number from 0 to 99. */
+static const char digit_pairs[201] =
+		"00010203040506070809"
+		"10111213141516171819"
+		"20212223242526272829"
+		"30313233343536373839"
+		"40414243444546474849"
+		"50515253545556575859"
+		"60616263646566676869"
+		"70717273747576777879"
+		"80818283848586878889"
+		"90919293949596979899";
+
+static const unsigned long long powers_of_10[20] = {
+	1ULL,
+	10ULL,
+	100ULL,
+	1000ULL,
+	10000ULL,
+	100000ULL,
+	1000000ULL,
+	10000000ULL,
+	100000000ULL,
+	1000000000ULL,
+	10000000000ULL,
+	100000000000ULL,
+	1000000000000ULL,
+	10000000000000ULL,
+	100000000000000ULL,
+	1000000000000000ULL,
+	10000000000000000ULL,
+	100000000000000000ULL,
+	1000000000000000000ULL,
+	10000000000000000000ULL
+};
+
+/*
+ * Number of decimal digits in value.  The number of bits approximates log10
+ * with a multiply and shift (1233 / 4096 ~ log10(2)), and one comparison
+ * corrects it.
+ */
+static inline int count_digits(unsigned long long value)
+{
+	int t;
+
+	/* Zero has one digit, and setting the low bit never adds a digit. */
+	value |= 1;
+	t = ((64 - __builtin_clzll(value)) * 1233) >> 12;
+
+	return t + (value >= powers_of_10[t]);
+}
+
+/* Write exactly length digits of value, two at a time from the end. */
+static inline void write_digits(char *str, unsigned long long value,
+		int length)
+{
+	char *p = str + length;
+
+	while (value >= 100) {
+		unsigned int i = (unsigned int) (value % 100) * 2;
+
+		value /= 100;
+		p -= 2;
+		p[0] = digit_pairs[i];
+		p[1] = digit_pairs[i + 1];
+	}
+	if (value >= 10) {
+		p -= 2;
+		p[0] = digit_pairs[value * 2];
+		p[1] = digit_pairs[value * 2 + 1];
+	} else
+		*--p = (char) ('0' + value);
+
+	/* Zero pad anything left over when a fixed width was requested. */
+	while (p > str)
+		*--p = '0';
+}
+
 int generate_query(char *in, char *out, struct query_t *q)
 {
 	FILE *fin, *fout;
@@ -101,26 +179,238 @@ int generate_query(char *in, char *out, struct query_t *q)
 	return 0;
 }
 
+/*
+ * Write the decimal representation of value into str, which must have room for
+ * MAX_INTEGER_LEN characters.  The string is not null terminated, the number of
+ * characters written is returned.
+ */
+int format_integer(char *str, long long value)
+{
+	unsigned long long u;
+	int length;
+	int sign = 0;
+
+	if (value < 0) {
+		*str++ = '-';
+		u = 0ULL - (unsigned long long) value;
+		sign = 1;
+	} else
+		u = (unsigned long long) value;
+
+	length = count_digits(u);
+	write_digits(str, u, length);
+
+	return length + sign;
+}
+
+/*
+ * Write a decimal number given as an integer of units of 10^-scale, such as
+ * 12345 with a scale of 2 as 123.45, into str.  There must be room for
+ * MAX_NUMERIC_LEN characters, the string is not null terminated, and the
+ * number of characters written is returned.
+ */
+int format_numeric(char *str, long long value, int scale)
+{
+	unsigned long long u;
+	int length;
+	int sign = 0;
+
+	if (scale == 0)
+		return format_integer(str, value);
+
+	if (value < 0) {
+		*str++ = '-';
+		u = 0ULL - (unsigned long long) value;
+		sign = 1;
+	} else
+		u = (unsigned long long) value;
+
+	/* Zero pad to at least one digit before the point, then insert it. */
+	length = count_digits(u);
+	if (length < scale + 1)
+		length = scale + 1;
+	write_digits(str, u, length);
+	memmove(str + length - scale + 1, str + length - scale, scale);
+	str[length - scale] = '.';
+
+	return length + 1 + sign;
+}
+
+/*
+ * Write an ISO-8601 date (YYYY-MM-DD) into str, which must have room for
+ * MAX_DATE_LEN characters.  The string is not null terminated, the number of
+ * characters written is returned.
+ */
+int format_date(char *str, int year, int month, int day)
+{
+	int length;
+
+	if (year < 0 || year > 9999)
+		length = format_integer(str, year);
+	else {
+		write_digits(str, year, 4);
+		length = 4;
+	}
+	str[length] = '-';
+	write_digits(str + length + 1, month, 2);
+	str[length + 3] = '-';
+	write_digits(str + length + 4, day, 2);
+
+	return length + 6;
+}
+
+/*
+ * Write an ISO-8601 timestamp (YYYY-MM-DDTHH:MM:SS.ffffff) of microseconds
+ * since 1970-01-01 into str, followed by Z if it is in UTC with a time zone.
+ * There must be room for MAX_TIMESTAMP_LEN characters, the string is not null
+ * terminated, and the number of characters written is returned.
+ */
+int format_timestamp(char *str, long long usec, int tz)
+{
+	long long days = usec / 86400000000LL;
+	long long time = usec % 86400000000LL;
+	int year, month, day;
+	int seconds;
+	int length;
+
+	if (time < 0) {
+		time += 86400000000LL;
+		--days;
+	}
+	civil_from_days((int) days, &year, &month, &day);
+	length = format_date(str, year, month, day);
+
+	seconds = (int) (time / 1000000);
+	str[length] = 'T';
+	write_digits(str + length + 1, seconds / 3600, 2);
+	str[length + 3] = ':';
+	write_digits(str + length + 4, seconds / 60 % 60, 2);
+	str[length + 6] = ':';
+	write_digits(str + length + 7, seconds % 60, 2);
+	str[length + 9] = '.';
+	write_digits(str + length + 10, time % 1000000, 6);
+	length += 16;
+	if (tz)
+		str[length++] = 'Z';
+
+	return length;
+}
+
 /* generates a random number on [0,1]-real-interval */
 double genrand64_real1(pcg64f_random_t *rng)
 {
-	return (pcg64f_random_r(rng) >> 11) * (1.0/9007199254740991.0);
+	return rand64_real1(pcg64f_random_r(rng));
 }
 
 /* generates a random number on [0,1)-real-interval */
 double genrand64_real2(pcg64f_random_t *rng)
 {
-	return (pcg64f_random_r(rng) >> 11) * (1.0 / 9007199254740992.0);
+	return rand64_real2(pcg64f_random_r(rng));
+}
+
+/* converts a 64-bit random number to the [0,1]-real-interval */
+double rand64_real1(unsigned long long r)
+{
+	return (r >> 11) * (1.0/9007199254740991.0);
+}
+
+/* converts a 64-bit random number to the [0,1)-real-interval */
+double rand64_real2(unsigned long long r)
+{
+	return (r >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * splitmix64 is a small counter based generator: the state only needs to be
+ * incremented and mixed, so deriving a handful of numbers from a single seed is
+ * much cheaper than seeding a new pcg64f generator.
+ */
+unsigned long long splitmix64(unsigned long long *state)
+{
+	unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/* generates a random number on [0,1]-real-interval from splitmix64 */
+double splitmix64_real1(unsigned long long *state)
+{
+	return rand64_real1(splitmix64(state));
+}
+
+/* generates a random number on [0,1)-real-interval from splitmix64 */
+double splitmix64_real2(unsigned long long *state)
+{
+	return rand64_real2(splitmix64(state));
+}
+
+/* The splitmix64 finalizer, a bijection that scrambles all 64 bits. */
+static inline unsigned long long mix64(unsigned long long z)
+{
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/*
+ * Random number for a counter under a key.  The result is a pure function of
+ * the two, so any counter can be computed without computing the ones before
+ * it.  The key is mixed in before and after scrambling the counter so that
+ * different keys do not produce shifted copies of the same sequence.
+ */
+unsigned long long counter_random(unsigned long long key,
+		unsigned long long counter)
+{
+	return mix64(mix64(counter * 0x9e3779b97f4a7c15ULL + key) ^ key);
+}
+
+/*
+ * Map a counter below size to a unique number below size for a key.  A Feistel
+ * network over the smallest even number of bits that can hold size is a
+ * bijection, and numbers it maps out of range are mapped again until they are
+ * in range, so any counter can be mapped without mapping the others.  A size
+ * of 0 stands for all 2^64 numbers.
+ */
+unsigned long long permute_counter(unsigned long long key,
+		unsigned long long counter, unsigned long long size)
+{
+	unsigned long long left, right, tmp, mask;
+	int half = 1;
+	int round;
+
+	while (half < 32 && (size == 0 || (size - 1) >> (2 * half) != 0))
+		++half;
+	mask = (1ULL << half) - 1;
+
+	do {
+		left = counter >> half;
+		right = counter & mask;
+		for (round = 0; round < 4; round++) {
+			tmp = right;
+			right = left ^ (counter_random(key, right << 2 | round) & mask);
+			left = tmp;
+		}
+		counter = left << half | right;
+	} while (size != 0 && counter >= size);
+
+	return counter;
 }
 
 void get_alpha(pcg64f_random_t *rng, char *str, int min, int max)
+{
+	/* Keep the data reproduceable by using the main rng to seed a new prng. */
+	get_alpha_seed(pcg64f_random_r(rng), str, min, max);
+}
+
+/* Same as get_alpha() but using the given seed for the new prng. */
+void get_alpha_seed(unsigned long long seed, char *str, int min, int max)
 {
 	int length;
 	int i;
 
-	/* Keep the data reproduceable by using the main rng to seed a new prng. */
 	pcg64f_random_t arng;
-	unsigned long long seed = pcg64f_random_r(rng);
 
 	pcg64f_srandom_r(&arng, seed);
 
@@ -130,12 +420,101 @@ void get_alpha(pcg64f_random_t *rng, char *str, int min, int max)
 		str[i] = alpha[(int) getrand(&arng, 0, ALPHA_LEN - 1)];
 }
 
+/*
+ * Fill str with length random letters.  Instead of one random number per
+ * letter, each 64-bit number is treated as a fraction in [0,1) that is
+ * repeatedly multiplied by ALPHA_LEN: the integer part of each product selects
+ * a letter and the fractional part is kept for the next one.  ALPHA_PER_RAND
+ * letters are taken from each number, and 52^8 is about 2^45.6, which leaves
+ * about 18 bits of the fraction unused so that the last letter is still
+ * uniform for all practical purposes.
+ */
+static inline void fill_alpha(unsigned long long *state, char *str, int length)
+{
+	pcg128_t fraction;
+	int i, n;
+
+	while (length > 0) {
+		fraction = splitmix64(state);
+		n = length < ALPHA_PER_RAND ? length : ALPHA_PER_RAND;
+		for (i = 0; i < n; i++) {
+			fraction *= ALPHA_LEN;
+			str[i] = alpha[(int) (fraction >> 64)];
+			fraction = (unsigned long long) fraction;
+		}
+		str += n;
+		length -= n;
+	}
+}
+
+/*
+ * Same as get_alpha() but every random number needed for the string is derived
+ * from the single seed with splitmix64, instead of seeding a new prng, and
+ * several letters are taken from each random number.
+ */
+void get_alpha_mix(unsigned long long seed, char *str, int min, int max)
+{
+	int length;
+
+	length = min + (int) ((max - min + 1) * splitmix64_real2(&seed));
+	fill_alpha(&seed, str, length);
+	str[length] = '\0';
+}
+
 void get_date(pcg64f_random_t *rng, struct tm *tm, time_t tloc1, time_t diff)
 {
-	time_t tloc = tloc1 + getrand(rng, 0, diff);
+	get_date_u64(pcg64f_random_r(rng), tm, tloc1, diff);
+}
+
+/* Same as get_date() but using the given 64-bit random number. */
+void get_date_u64(unsigned long long r, struct tm *tm, time_t tloc1,
+		time_t diff)
+{
+	time_t tloc = tloc1 + getrandU64(r, 0, diff);
 	localtime_r(&tloc, tm);
 }
 
+/*
+ * Number of days from 1970-01-01 to the given proleptic Gregorian date, month
+ * and day counting from 1.  Uses Howard Hinnant's days_from_civil() algorithm,
+ * which works in 400 year eras starting from March so that leap days fall at
+ * the end of each year.
+ */
+int days_from_civil(int year, int month, int day)
+{
+	int era;
+	int yoe, doy, doe;
+
+	year -= month <= 2;
+	era = (year >= 0 ? year : year - 399) / 400;
+	yoe = year - era * 400;
+	doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+	return era * 146097 + doe - 719468;
+}
+
+/*
+ * The inverse of days_from_civil(): the proleptic Gregorian date that is the
+ * given number of days from 1970-01-01, month and day counting from 1.
+ */
+void civil_from_days(int days, int *year, int *month, int *day)
+{
+	int era;
+	int doe, yoe, doy, mp;
+
+	days += 719468;
+	era = (days >= 0 ? days : days - 146096) / 146097;
+	doe = days - era * 146097;
+	yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	mp = (5 * doy + 2) / 153;
+
+	*day = doy - (153 * mp + 2) / 5 + 1;
+	*month = mp < 10 ? mp + 3 : mp - 9;
+	*year = yoe + era * 400 + (*month <= 2);
+}
+
 int get_days(int year)
 {
 	time_t tloc1, tloc2;
@@ -11,13 +11,53 @@
 #include "entropy.h"
 
 #define ALPHA_LEN 52
+/* Letters get_alpha_mix() takes from each 64-bit random number. */
+#define ALPHA_PER_RAND 8
 #define BUFFER_LEN 64
 
+/*
+ * Longest text from format_integer(), format_date() and format_timestamp(),
+ * which adds the time with microseconds and a time zone to a date.
+ */
+#define MAX_INTEGER_LEN 20
+#define MAX_DATE_LEN 17
+#define MAX_TIMESTAMP_LEN (MAX_DATE_LEN + 17)
+/*
+ * Longest text from format_numeric(), a sign, a point and the 19 digits of a
+ * 64-bit integer, which holds any numeric of up to 18 digits.
+ */
+#define MAX_NUMERIC_LEN 21
+#define MAX_NUMERIC_PRECISION 18
+
+/*
+ * Versions of the data produced for the same seed.  Version 1 seeds a new
+ * pcg64f generator from the main one for column types that need more than one
+ * random number per value.  Version 2 derives those numbers from a single draw
+ * with splitmix64 instead, and takes several letters of text from each one.
+ * Version 3 generates values the same way as version 2, but the random number
+ * for each value is computed from its row and column with counter_random()
+ * instead of being taken from the main generator.
+ */
+#define DATA_VERSION_1 1
+#define DATA_VERSION_2 2
+#define DATA_VERSION_3 3
+#define DATA_VERSION_MAX DATA_VERSION_3
+
 #define MAXVAR 9
 #define VAR_LEN 256
 
 #define int64 long int
 
+/* Constants for getZipfianRand(), worked out once by setZipfian(). */
+struct zipfian_t {
+	int64 min;
+	int64 n; /* Number of values from min. */
+	double exponent;
+	double h_integral_x1;
+	double h_integral_n;
+	double s;
+};
+
 struct query_t {
 	int flag_analyze;
 	int flag_plan;
@@ -32,16 +72,43 @@ struct query_t {
 	char var[MAXVAR][VAR_LEN];
 };
 
+void civil_from_days(int, int *, int *, int *);
+unsigned long long counter_random(unsigned long long, unsigned long long);
+int days_from_civil(int, int, int);
+int format_date(char *, int, int, int);
+int format_integer(char *, long long);
+int format_numeric(char *, long long, int);
+int format_timestamp(char *, long long, int);
 int generate_query(char *, char *, struct query_t *);
 double genrand64_real1(pcg64f_random_t *);
 double genrand64_real2(pcg64f_random_t *);
 void get_alpha(pcg64f_random_t *, char *, int, int);
+void get_alpha_mix(unsigned long long, char *, int, int);
+void get_alpha_seed(unsigned long long, char *, int, int);
 void get_date(pcg64f_random_t *, struct tm *, time_t, time_t);
+void get_date_u64(unsigned long long, struct tm *, time_t, time_t);
 int get_days(int);
 int64 getExponentialRand(pcg64f_random_t *, int64, int64, double);
+int64 getExponentialRandU64(unsigned long long, int64, int64, double);
 int64 getGaussianRand(pcg64f_random_t *, int64, int64, double);
+int64 getGaussianRandMix(unsigned long long, int64, int64, double);
+int64 getGaussianRandSeed(unsigned long long, int64, int64, double);
+int64 getHotspotRand(pcg64f_random_t *, int64, int64, double, double);
+int64 getHotspotRandU64(unsigned long long, int64, int64, double, double);
 int64 getPoissonRand(pcg64f_random_t *, int64);
+int64 getPoissonRandU64(unsigned long long, int64);
 int64 getrand(pcg64f_random_t *, int64, int64);
+int64 getrandU64(unsigned long long, int64, int64);
+int64 getZipfianRand(pcg64f_random_t *, const struct zipfian_t *);
+int64 getZipfianRandMix(unsigned long long, const struct zipfian_t *);
 int load_query_parameters(char *, struct query_t *);
+unsigned long long permute_counter(unsigned long long, unsigned long long,
+		unsigned long long);
+double rand64_real1(unsigned long long);
+double rand64_real2(unsigned long long);
+void setZipfian(struct zipfian_t *, int64, int64, double);
+unsigned long long splitmix64(unsigned long long *);
+double splitmix64_real1(unsigned long long *);
+double splitmix64_real2(unsigned long long *);
 
 #endif /* _TOUCHSTONE_H_ */